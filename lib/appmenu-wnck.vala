@@ -171,10 +171,12 @@ namespace Appmenu
         }
         private void on_active_window_changed(Wnck.Window? prev)
         {
+            LatencyTracer.begin();
             reset_menu_update_timeout();
             unowned Wnck.Window win = screen.get_active_window();
             type = ModelType.NONE;
             lookup_menu(win);
+            LatencyTracer.mark(LatencyStage.LOOKUP);
             active_model_changed();
         }
         private void lookup_menu(Wnck.Window? window)
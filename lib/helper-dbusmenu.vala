@@ -26,20 +26,44 @@ namespace Appmenu
         private DBusMenu.Importer importer = null;
         private Helper dbus_helper = null;
         private ulong connect_handler = 0;
+        private ulong received_handler = 0;
+        private ulong applied_handler = 0;
         public DBusMenuHelper(MenuWidget w, string name, ObjectPath path, string? title, DesktopAppInfo? info)
         {
             dbus_helper = new DBusAppMenu(w, title, name, info);
-            importer = new DBusMenu.Importer(name,(string)path);
+            /* Recently focused windows reuse their importer with already loaded menus */
+            importer = DBusMenu.Importer.get_cached(name,(string)path);
+            LatencyTracer.mark(LatencyStage.IMPORTER);
+            /* Window got focus, so its menus will be opened soon: fetch submenus of menubar too */
+            importer.prefetch_depth = 2;
+            /* Focus switch should not wait for properties before requesting layout */
+            importer.fast_connect = true;
             connect_handler = Signal.connect(importer,"notify::model",(GLib.Callback)on_model_changed_cb,w);
+            received_handler = Signal.connect(importer,"layout-received",(GLib.Callback)on_layout_received_cb,null);
+            applied_handler = Signal.connect(importer,"layout-applied",(GLib.Callback)on_layout_applied_cb,null);
+            /* Model always has its first section, so loaded layout is seen by items in it */
+            var section = importer.model.get_item_link(0,GLib.Menu.LINK_SECTION);
+            if (section != null && section.get_n_items() > 0)
+                on_model_changed_cb(importer,null,w);
         }
-        private static void on_model_changed_cb(DBusMenu.Importer importer, GLib.ParamSpec pspec, MenuWidget w)
+        private static void on_model_changed_cb(DBusMenu.Importer importer, GLib.ParamSpec? pspec, MenuWidget w)
         {
             w.insert_action_group("dbusmenu",importer.action_group);
             w.set_menubar(importer.model);
         }
+        private static void on_layout_received_cb(DBusMenu.Importer importer, void* data)
+        {
+            LatencyTracer.mark(LatencyStage.LAYOUT_RECEIVED);
+        }
+        private static void on_layout_applied_cb(DBusMenu.Importer importer, void* data)
+        {
+            LatencyTracer.mark(LatencyStage.LAYOUT_APPLIED);
+        }
         ~DBusMenuHelper()
         {
             importer.disconnect(connect_handler);
+            importer.disconnect(received_handler);
+            importer.disconnect(applied_handler);
         }
     }
 }
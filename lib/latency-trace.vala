@@ -0,0 +1,121 @@
+/*
+ * vala-panel-appmenu
+ * Copyright (C) 2018 Konstantin Pugin <ria.freelander@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+using GLib;
+
+namespace Appmenu
+{
+    /* Stages of showing menu for focused window, in order they usually happen */
+    public enum LatencyStage
+    {
+        LOOKUP,
+        IMPORTER,
+        HELPER,
+        LAYOUT_RECEIVED,
+        LAYOUT_APPLIED,
+        MENUBAR;
+        public const int COUNT = 6;
+        public unowned string to_nick()
+        {
+            switch (this)
+            {
+                case LOOKUP: return "lookup";
+                case IMPORTER: return "importer";
+                case HELPER: return "helper";
+                case LAYOUT_RECEIVED: return "layout-received";
+                case LAYOUT_APPLIED: return "layout-applied";
+                default: return "menubar";
+            }
+        }
+    }
+    /*
+     * Opt-in tracing of focus-to-menu latency, enabled by APPMENU_LATENCY_TRACE environment
+     * variable. Every stage is stamped once per focus change, and time since focus change is
+     * counted in histogram, which is exported on session bus. Stamps are printed with
+     * G_MESSAGES_DEBUG too.
+     */
+    [DBus (name = "org.valapanel.AppMenu.Latency")]
+    public class LatencyTracer : Object
+    {
+        private const string OBJECT_PATH = "/org/valapanel/AppMenu/Latency";
+        /* Bucket i counts latencies below 1 << i milliseconds, last one counts the rest */
+        private const int N_BUCKETS = 13;
+        private static bool initialized = false;
+        private static LatencyTracer? instance = null;
+        private int64 start = 0;
+        private bool marked[LatencyStage.COUNT];
+        private uint counts[LatencyStage.COUNT * N_BUCKETS];
+        public static void begin()
+        {
+            unowned LatencyTracer? tracer = get_default();
+            if (tracer == null)
+                return;
+            tracer.start = get_monotonic_time();
+            for (var i = 0; i < LatencyStage.COUNT; i++)
+                tracer.marked[i] = false;
+        }
+        public static void mark(LatencyStage stage)
+        {
+            unowned LatencyTracer? tracer = get_default();
+            if (tracer == null || tracer.start == 0 || tracer.marked[stage])
+                return;
+            tracer.marked[stage] = true;
+            var usec = get_monotonic_time() - tracer.start;
+            var bucket = 0;
+            while (bucket < N_BUCKETS - 1 && usec >= (1000 << bucket))
+                bucket++;
+            tracer.counts[stage * N_BUCKETS + bucket]++;
+            debug("Focus latency: %s after %" + int64.FORMAT + " usec", stage.to_nick(), usec);
+        }
+        private static unowned LatencyTracer? get_default()
+        {
+            if (initialized)
+                return instance;
+            initialized = true;
+            if (Environment.get_variable("APPMENU_LATENCY_TRACE") == null)
+                return null;
+            instance = new LatencyTracer();
+            try {
+                var con = Bus.get_sync(BusType.SESSION);
+                con.register_object(OBJECT_PATH, instance);
+            } catch (Error e) {stderr.printf("%s\n",e.message);}
+            return instance;
+        }
+        /* Upper bounds of buckets in microseconds, and bucket counts for every stage */
+        public void get_histograms(out uint[] bounds_usec, [DBus (signature = "a(sau)")] out Variant histograms)
+        {
+            bounds_usec = new uint[N_BUCKETS - 1];
+            for (var i = 0; i < N_BUCKETS - 1; i++)
+                bounds_usec[i] = 1000 << i;
+            var builder = new VariantBuilder(new VariantType("a(sau)"));
+            for (var stage = 0; stage < LatencyStage.COUNT; stage++)
+            {
+                var stage_counts = new VariantBuilder(new VariantType("au"));
+                for (var i = 0; i < N_BUCKETS; i++)
+                    stage_counts.add("u", counts[stage * N_BUCKETS + i]);
+                builder.add("(sau)", ((LatencyStage)stage).to_nick(), stage_counts);
+            }
+            histograms = builder.end();
+        }
+        public void reset()
+        {
+            for (var i = 0; i < LatencyStage.COUNT * N_BUCKETS; i++)
+                counts[i] = 0;
+        }
+    }
+}
@@ -39,6 +39,8 @@ namespace Appmenu
         private Gtk.MenuBar mwidget = new Gtk.MenuBar();
         private ulong backend_connector = 0;
         private ulong compact_connector = 0;
+        private GLib.MenuModel? traced_section = null;
+        private ulong traced_connector = 0;
         construct
         {
             provider = new Gtk.CssProvider();
@@ -50,6 +52,7 @@ namespace Appmenu
             backend_connector = backend.active_model_changed.connect(()=>{
                 Timeout.add(50,()=>{
                     backend.set_active_window_menu(this);
+                    LatencyTracer.mark(LatencyStage.HELPER);
                     return Source.REMOVE;
                 });
             });
@@ -127,6 +130,34 @@ namespace Appmenu
         {
             this.menubar = menubar_model;
             this.restock();
+            trace_menubar();
+        }
+        /* Menubar is shown when its first section gets items, DBusMenu models always have it */
+        private void trace_menubar()
+        {
+            if (traced_connector > 0)
+            {
+                traced_section.disconnect(traced_connector);
+                traced_connector = 0;
+                traced_section = null;
+            }
+            if (this.menubar == null || this.menubar.get_n_items() == 0)
+                return;
+            var section = this.menubar.get_item_link(0,GLib.Menu.LINK_SECTION) ?? this.menubar;
+            if (section.get_n_items() > 0)
+            {
+                LatencyTracer.mark(LatencyStage.MENUBAR);
+                return;
+            }
+            traced_section = section;
+            traced_connector = section.items_changed.connect((a,b,c)=>{
+                if (traced_section.get_n_items() == 0)
+                    return;
+                LatencyTracer.mark(LatencyStage.MENUBAR);
+                traced_section.disconnect(traced_connector);
+                traced_connector = 0;
+                traced_section = null;
+            });
         }
         protected bool on_scroll_event(Gtk.Widget w, Gdk.EventScroll event)
         {
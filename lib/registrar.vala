@@ -47,11 +47,35 @@ namespace Appmenu
         public signal void menu_shown(string service, ObjectPath path);
         public signal void menu_hidden(string service, ObjectPath path);
     }
+    [DBus (name = "org.valapanel.AppMenu.Registrar")]
+    public interface InnerRegistrar : DBusProxy
+    {
+        public signal void windows_changed([DBus (signature="a(uso)")] Variant registered, uint[] unregistered);
+        public abstract void get_menus_since(uint64 revision, out uint64 current_revision, out bool full,
+                                             [DBus (signature="a(uso)")] out Variant added, out uint[] removed) throws Error;
+    }
+    [Compact]
+    internal class RegisteredMenu
+    {
+        internal string name;
+        internal ObjectPath path;
+        internal RegisteredMenu(string name, ObjectPath path)
+        {
+            this.name = name;
+            this.path = path;
+        }
+    }
     public class DBusMenuRegistrarProxy: Object
     {
         public bool have_registrar {get; private set;}
         private OuterRegistrar outer_registrar;
+        private InnerRegistrar inner_registrar;
         private uint watched_name;
+        /* Local mirror of registrar table, so focus changes do not need D-Bus calls */
+        private HashTable<uint,RegisteredMenu> menus;
+        private uint64 revision;
+        /* Registrar has private interface, so every change comes in one WindowsChanged */
+        private bool batched;
         public DBusMenuRegistrarProxy()
         {
             Object();
@@ -59,14 +83,81 @@ namespace Appmenu
         public signal void registrar_changed(bool have_registrar);
         public signal void window_registered(uint window_id, string service, ObjectPath path);
         public signal void window_unregistered(uint window_id);
+        private void add_menus(Variant added)
+        {
+            foreach (var entry in added)
+            {
+                uint window;
+                string name;
+                string path;
+                entry.get("(uso)",out window, out name, out path);
+                menus.insert(window,new RegisteredMenu(name,new ObjectPath(path)));
+            }
+        }
+        private void on_windows_changed(Variant registered, uint[] unregistered)
+        {
+            foreach (var window in unregistered)
+            {
+                menus.remove(window);
+                this.window_unregistered(window);
+            }
+            foreach (var entry in registered)
+            {
+                uint window;
+                string name;
+                string path;
+                entry.get("(uso)",out window, out name, out path);
+                var obj_path = new ObjectPath(path);
+                menus.insert(window,new RegisteredMenu(name,obj_path));
+                this.window_registered(window,name,obj_path);
+            }
+        }
+        private void resync_menus()
+        {
+            Variant added;
+            try{
+                bool full;
+                uint[] removed;
+                inner_registrar.get_menus_since(revision,out revision,out full,out added,out removed);
+                if (full)
+                    menus.remove_all();
+                foreach (var window in removed)
+                    menus.remove(window);
+                add_menus(added);
+                batched = true;
+                return;
+            } catch (Error e) {debug("%s",e.message);}
+            batched = false;
+            /* Registrar without private interface, fetch whole table */
+            try{
+                outer_registrar.get_menus(out added);
+                menus.remove_all();
+                add_menus(added);
+            } catch (Error e) {stderr.printf("%s\n",e.message);}
+        }
         private void create_outer_registrar()
         {
             watched_name = Bus.watch_name(BusType.SESSION,REG_IFACE,GLib.BusNameWatcherFlags.NONE,
                                                     () => {
                                                         try{
                                                             outer_registrar = Bus.get_proxy_sync(BusType.SESSION,REG_IFACE,REG_OBJECT);
-                                                            outer_registrar.window_registered.connect((w,s,p)=>{this.window_registered(w,s,p);});
-                                                            outer_registrar.window_unregistered.connect((w)=>{this.window_unregistered(w);});
+                                                            /* Per-window signals are used only by registrars without private interface */
+                                                            outer_registrar.window_registered.connect((w,s,p)=>{
+                                                                if (batched)
+                                                                    return;
+                                                                menus.insert(w,new RegisteredMenu(s,p));
+                                                                this.window_registered(w,s,p);
+                                                            });
+                                                            outer_registrar.window_unregistered.connect((w)=>{
+                                                                if (batched)
+                                                                    return;
+                                                                menus.remove(w);
+                                                                this.window_unregistered(w);
+                                                            });
+                                                            inner_registrar = Bus.get_proxy_sync(BusType.SESSION,"org.valapanel.AppMenu.Registrar","/org/valapanel/AppMenu/Registrar",
+                                                                                                 DBusProxyFlags.DO_NOT_LOAD_PROPERTIES | DBusProxyFlags.DO_NOT_AUTO_START);
+                                                            inner_registrar.windows_changed.connect(on_windows_changed);
+                                                            resync_menus();
                                                             have_registrar = true;
                                                             registrar_changed(true);
                                                         } catch (Error e) {stderr.printf("%s\n",e.message);}
@@ -74,6 +165,8 @@ namespace Appmenu
                                                     () => {
                                                         have_registrar = false;
                                                         outer_registrar = null;
+                                                        inner_registrar = null;
+                                                        menus.remove_all();
                                                         registrar_changed(false);
                                                         }
                                                     );
@@ -81,14 +174,18 @@ namespace Appmenu
         construct
         {
             have_registrar = false;
+            menus = new HashTable<uint,RegisteredMenu>(direct_hash,direct_equal);
+            revision = 0;
+            batched = false;
             try{
+                /* Only activate registrar here, without transferring the menu table */
                 var con = Bus.get_sync(BusType.SESSION);
                 con.call_sync(
-                    DBUS_NAME,
-                    REG_OBJECT,
-                    REG_IFACE,
-                    "GetMenus",
-                    null,null,
+                    "org.freedesktop.DBus",
+                    "/org/freedesktop/DBus",
+                    "org.freedesktop.DBus",
+                    "StartServiceByName",
+                    new Variant("(su)",DBUS_NAME,0),null,
                     DBusCallFlags.NONE, -1);
             }
             catch(Error e)
@@ -103,9 +200,11 @@ namespace Appmenu
             path = new ObjectPath("/");
             if (!have_registrar)
                 return;
-            try{
-                outer_registrar.get_menu_for_window(window,out name, out path);
-            } catch (Error e) {stderr.printf("%s\n",e.message);}
+            unowned RegisteredMenu? menu = menus.lookup(window);
+            if (menu == null)
+                return;
+            name = menu.name;
+            path = menu.path;
         }
         ~DBusMenuRegistrarProxy()
         {
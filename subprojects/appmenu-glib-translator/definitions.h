@@ -25,7 +25,6 @@
 #define ACTION_PREFIX "id-"
 #define SUBMENU_PREFIX "submenu-"
 #define CURRENT_TIME 0L
-#define HAS_ICON_NAME "has-icon-name"
 
 typedef enum
 {
@@ -40,6 +39,28 @@ typedef enum
 #define SUBMENU_ACTION_MENUMODEL_QUARK_STR "submenu-action_menumodel"
 #define ACTIVATE_ID_QUARK_STR "checker-quark"
 #define POPULATED_QUARK "is-populated"
+#define EVENT_QUEUE_QUARK_STR "dbusmenu-event-queue"
+
+// Default timeout for calls to a single client, in milliseconds
+#define DBUS_MENU_CALL_TIMEOUT 5000
+
+// Default limits for nested layouts which are prefetched for one application
+#define DBUS_MENU_PREFETCH_MAX_ITEMS 2048
+#define DBUS_MENU_PREFETCH_MAX_BYTES (1 << 20)
+// Number of submenus which are preloaded in one batch
+#define DBUS_MENU_PREFETCH_SLICE 16
+
+// Limits of the icon cache shared by all menus, and size of icon data which is kept as is.
+// Bigger icons are scaled down to DBUS_MENU_ICON_SIZE pixels.
+#define DBUS_MENU_ICON_CACHE_MAX_ITEMS 256
+#define DBUS_MENU_ICON_CACHE_MAX_BYTES (4 << 20)
+#define DBUS_MENU_ICON_MAX_BYTES (64 << 10)
+#define DBUS_MENU_ICON_SIZE 32
+
+// Limits of recently used importers kept alive for switching back to their windows.
+// Size is counted in menu items of importers which are not in use.
+#define DBUS_MENU_IMPORTER_POOL_MAX_ENTRIES 8
+#define DBUS_MENU_IMPORTER_POOL_MAX_ITEMS 8192
 
 #define DBUS_MENU_PROP_TYPE "type"
 #define DBUS_MENU_TYPE_SEPARATOR "separator"
@@ -49,6 +70,10 @@ typedef enum
 #define DBUS_MENU_TOGGLE_TYPE_CHECK "checkmark"
 #define DBUS_MENU_TOGGLE_TYPE_RADIO "radio"
 
+#define DBUS_MENU_EVENT_CLICKED "clicked"
+#define DBUS_MENU_EVENT_OPENED "opened"
+#define DBUS_MENU_EVENT_CLOSED "closed"
+
 #define DBUS_MENU_PROP_CHILDREN_DISPLAY "children-display"
 #define DBUS_MENU_CHILDREN_DISPLAY_SUBMENU "submenu"
 
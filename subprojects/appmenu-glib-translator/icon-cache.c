@@ -0,0 +1,153 @@
+/*
+ * vala-panel-appmenu
+ * Copyright (C) 2018 Konstantin Pugin <ria.freelander@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "icon-cache.h"
+#include "definitions.h"
+
+#ifdef HAVE_GDKPIXBUF
+#include "item-pixbuf.c"
+#endif
+
+// Serialized icons, shared by all items of all menus in the process. Icon data is not
+// decoded here: it is kept as GBytesIcon, which is loaded by toolkit when item is shown.
+// Only oversized data is decoded once and scaled down.
+typedef struct
+{
+	char *key;
+	GVariant *icon;
+	gsize size;
+} IconCacheEntry;
+
+typedef struct
+{
+	GHashTable *entries;
+	// Most recently used entries are in head
+	GQueue lru;
+	gsize size;
+} IconCache;
+
+static void icon_cache_entry_free(IconCacheEntry *entry)
+{
+	g_clear_pointer(&entry->key, g_free);
+	g_clear_pointer(&entry->icon, g_variant_unref);
+	g_slice_free(IconCacheEntry, entry);
+}
+
+static IconCache *icon_cache_get(void)
+{
+	static IconCache *cache = NULL;
+	if (g_once_init_enter(&cache))
+	{
+		IconCache *new_cache = g_slice_new0(IconCache);
+		new_cache->entries   = g_hash_table_new(g_str_hash, g_str_equal);
+		g_queue_init(&new_cache->lru);
+		g_once_init_leave(&cache, new_cache);
+	}
+	return cache;
+}
+
+static GVariant *icon_cache_lookup(IconCache *cache, const char *key)
+{
+	GList *link = (GList *)g_hash_table_lookup(cache->entries, key);
+	if (link == NULL)
+		return NULL;
+	g_queue_unlink(&cache->lru, link);
+	g_queue_push_head_link(&cache->lru, link);
+	return g_variant_ref(((IconCacheEntry *)link->data)->icon);
+}
+
+// Takes ownership of key and icon. Evicted icons stay alive while items reference them.
+static void icon_cache_insert(IconCache *cache, char *key, GVariant *icon)
+{
+	IconCacheEntry *entry = g_slice_new0(IconCacheEntry);
+	entry->key            = key;
+	entry->icon           = icon;
+	entry->size           = g_variant_get_size(entry->icon);
+	g_queue_push_head(&cache->lru, entry);
+	g_hash_table_insert(cache->entries, entry->key, cache->lru.head);
+	cache->size += entry->size;
+	while (cache->lru.length > 1 && (cache->lru.length > DBUS_MENU_ICON_CACHE_MAX_ITEMS ||
+	                                 cache->size > DBUS_MENU_ICON_CACHE_MAX_BYTES))
+	{
+		IconCacheEntry *old = (IconCacheEntry *)g_queue_pop_tail(&cache->lru);
+		g_hash_table_remove(cache->entries, old->key);
+		cache->size -= old->size;
+		icon_cache_entry_free(old);
+	}
+}
+
+static GVariant *icon_serialize_data(const guchar *data, gsize length)
+{
+	g_autoptr(GBytes) bytes = g_bytes_new(data, length);
+	if (length > DBUS_MENU_ICON_MAX_BYTES)
+	{
+#ifdef HAVE_GDKPIXBUF
+		return icon_serialize_scaled(bytes, DBUS_MENU_ICON_SIZE);
+#else
+		g_debug("Icon data of %" G_GSIZE_FORMAT " bytes is too big, skipping it", length);
+		return NULL;
+#endif
+	}
+	g_autoptr(GIcon) icon = g_bytes_icon_new(bytes);
+	return g_icon_serialize(icon);
+}
+
+// Returns serialized icon for icon-data property, keyed by checksum of its contents
+G_GNUC_INTERNAL GVariant *dbus_menu_icon_cache_lookup_data(GVariant *data)
+{
+	gsize length;
+	const guchar *bytes =
+	    (const guchar *)g_variant_get_fixed_array(data, &length, sizeof(guchar));
+	if (length == 0)
+		return NULL;
+	IconCache *cache     = icon_cache_get();
+	g_autofree char *sum = g_compute_checksum_for_data(G_CHECKSUM_SHA1, bytes, length);
+	char *key            = g_strconcat("data:", sum, NULL);
+	GVariant *icon       = icon_cache_lookup(cache, key);
+	if (icon != NULL)
+	{
+		g_free(key);
+		return icon;
+	}
+	icon = icon_serialize_data(bytes, length);
+	if (icon == NULL)
+	{
+		g_free(key);
+		return NULL;
+	}
+	icon_cache_insert(cache, key, icon);
+	return g_variant_ref(icon);
+}
+
+G_GNUC_INTERNAL GVariant *dbus_menu_icon_cache_lookup_name(const char *name)
+{
+	if (name == NULL || *name == '\0')
+		return NULL;
+	IconCache *cache = icon_cache_get();
+	char *key        = g_strconcat("name:", name, NULL);
+	GVariant *icon   = icon_cache_lookup(cache, key);
+	if (icon != NULL)
+	{
+		g_free(key);
+		return icon;
+	}
+	g_autoptr(GIcon) themed = g_themed_icon_new(name);
+	icon                    = g_icon_serialize(themed);
+	icon_cache_insert(cache, key, icon);
+	return g_variant_ref(icon);
+}
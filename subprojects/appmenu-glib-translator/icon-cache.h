@@ -0,0 +1,31 @@
+/*
+ * vala-panel-appmenu
+ * Copyright (C) 2018 Konstantin Pugin <ria.freelander@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ICON_CACHE_H
+#define ICON_CACHE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL GVariant *dbus_menu_icon_cache_lookup_data(GVariant *data);
+G_GNUC_INTERNAL GVariant *dbus_menu_icon_cache_lookup_name(const char *name);
+
+G_END_DECLS
+
+#endif // ICON_CACHE_H
@@ -18,7 +18,9 @@
 
 #include "importer.h"
 #include "dbusmenu-interface.h"
+#include "definitions.h"
 #include "model.h"
+#include "utils.h"
 
 struct _DBusMenuImporter
 {
@@ -30,6 +32,10 @@ struct _DBusMenuImporter
 	DBusMenuXml *proxy;
 	DBusMenuModel *top_model;
 	GSimpleActionGroup *all_actions;
+	int prefetch_depth;
+	uint prefetch_max_items;
+	uint prefetch_max_bytes;
+	bool fast_connect;
 };
 
 enum
@@ -39,12 +45,104 @@ enum
 	PROP_OBJECT_PATH,
 	PROP_MODEL,
 	PROP_ACTION_GROUP,
+	PROP_PREFETCH_DEPTH,
+	PROP_PREFETCH_MAX_ITEMS,
+	PROP_PREFETCH_MAX_BYTES,
+	PROP_FAST_CONNECT,
 	LAST_PROP
 };
 
 static GParamSpec *properties[LAST_PROP] = { NULL };
+
+enum
+{
+	LAYOUT_RECEIVED_SIGNAL,
+	LAYOUT_APPLIED_SIGNAL,
+	LAST_SIGNAL
+};
+
+static uint signals[LAST_SIGNAL] = { 0 };
 G_DEFINE_TYPE(DBusMenuImporter, dbus_menu_importer, G_TYPE_OBJECT)
 
+// Recently used importers. They keep their models populated and follow LayoutUpdated, so
+// switching back to a window does not fetch its menus again.
+typedef struct
+{
+	char *key;
+	DBusMenuImporter *importer;
+	uint n_items;
+} ImporterPoolEntry;
+
+typedef struct
+{
+	GHashTable *entries;
+	// Most recently used entries are in head
+	GQueue lru;
+	uint n_items;
+} ImporterPool;
+
+static void importer_pool_entry_free(ImporterPoolEntry *entry)
+{
+	g_clear_pointer(&entry->key, g_free);
+	g_clear_object(&entry->importer);
+	g_slice_free(ImporterPoolEntry, entry);
+}
+
+static ImporterPool *importer_pool_get(void)
+{
+	static ImporterPool *pool = NULL;
+	if (g_once_init_enter(&pool))
+	{
+		ImporterPool *new_pool = g_slice_new0(ImporterPool);
+		new_pool->entries      = g_hash_table_new(g_str_hash, g_str_equal);
+		g_queue_init(&new_pool->lru);
+		g_once_init_leave(&pool, new_pool);
+	}
+	return pool;
+}
+
+// Every item with action is in the shared action group, so it is used as size of menus
+static void importer_pool_measure(ImporterPool *pool, ImporterPoolEntry *entry)
+{
+	g_auto(GStrv) actions =
+	    g_action_group_list_actions(G_ACTION_GROUP(entry->importer->all_actions));
+	pool->n_items -= entry->n_items;
+	entry->n_items = g_strv_length(actions);
+	pool->n_items += entry->n_items;
+}
+
+static void importer_pool_remove_link(ImporterPool *pool, GList *link)
+{
+	ImporterPoolEntry *entry = (ImporterPoolEntry *)link->data;
+	g_queue_delete_link(&pool->lru, link);
+	g_hash_table_remove(pool->entries, entry->key);
+	pool->n_items -= entry->n_items;
+	importer_pool_entry_free(entry);
+}
+
+// Pooled importers follow LayoutUpdated, so any of them could have grown since it was
+// measured. Pool holds at most DBUS_MENU_IMPORTER_POOL_MAX_ENTRIES, so all are measured.
+static void importer_pool_trim(ImporterPool *pool)
+{
+	for (GList *link = pool->lru.head; link != NULL; link = link->next)
+		importer_pool_measure(pool, (ImporterPoolEntry *)link->data);
+	while (pool->lru.length > 1 && (pool->lru.length > DBUS_MENU_IMPORTER_POOL_MAX_ENTRIES ||
+	                                pool->n_items > DBUS_MENU_IMPORTER_POOL_MAX_ITEMS))
+		importer_pool_remove_link(pool, pool->lru.tail);
+}
+
+// Importer of application which left the bus will never be populated again
+static void importer_pool_remove(DBusMenuImporter *menu)
+{
+	ImporterPool *pool = importer_pool_get();
+	for (GList *link = pool->lru.head; link != NULL; link = link->next)
+		if (((ImporterPoolEntry *)link->data)->importer == menu)
+		{
+			importer_pool_remove_link(pool, link);
+			return;
+		}
+}
+
 static bool dbus_menu_importer_check(DBusMenuImporter *menu)
 {
 	if (DBUS_MENU_IS_XML(menu->proxy))
@@ -59,6 +157,42 @@ static void dbus_menu_importer_on_root_model_changed(GMenuModel *model, gint pos
 	g_object_notify_by_pspec(G_OBJECT(menu), properties[PROP_MODEL]);
 }
 
+// Only the root layout is forwarded, submenus are loaded when menubar is already shown
+static void dbus_menu_importer_on_root_layout_received(DBusMenuModel *model, gpointer user_data)
+{
+	g_signal_emit(user_data, signals[LAYOUT_RECEIVED_SIGNAL], 0);
+}
+
+static void dbus_menu_importer_on_root_layout_applied(DBusMenuModel *model, gpointer user_data)
+{
+	g_signal_emit(user_data, signals[LAYOUT_APPLIED_SIGNAL], 0);
+}
+
+static void version_ready_cb(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) ret =
+	    g_dbus_connection_call_finish(G_DBUS_CONNECTION(source_object), res, &error);
+
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	DBusMenuImporter *menu = DBUS_MENU_IMPORTER(user_data);
+	if (!DBUS_MENU_IS_XML(menu->proxy))
+		return;
+	if (ret != NULL)
+	{
+		g_autoptr(GVariant) version = NULL;
+		g_variant_get(ret, "(v)", &version);
+		g_dbus_proxy_set_cached_property(G_DBUS_PROXY(menu->proxy), "Version", version);
+	}
+	if (dbus_menu_importer_check(menu))
+		return;
+	g_debug("Menu %s%s has unsupported version, dropping it", menu->bus_name, menu->object_path);
+	g_object_set(menu->top_model, "xml", NULL, NULL);
+	g_object_notify_by_pspec(G_OBJECT(menu), properties[PROP_MODEL]);
+}
+
 static void proxy_ready_cb(GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(GError) error = NULL;
@@ -75,7 +209,27 @@ static void proxy_ready_cb(GObject *source_object, GAsyncResult *res, gpointer u
 		g_warning("%s", error->message);
 		return;
 	}
-	if (dbus_menu_importer_check(menu))
+	// Slow client should not hold its menus for the whole default D-Bus timeout
+	g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(proxy), DBUS_MENU_CALL_TIMEOUT);
+	dbus_menu_event_set_cancellable(proxy, menu->cancellable);
+	if (menu->fast_connect)
+	{
+		// Layout is requested together with version, and dropped if version is too old
+		g_dbus_connection_call(g_dbus_proxy_get_connection(G_DBUS_PROXY(proxy)),
+		                       menu->bus_name,
+		                       menu->object_path,
+		                       "org.freedesktop.DBus.Properties",
+		                       "Get",
+		                       g_variant_new("(ss)", "com.canonical.dbusmenu", "Version"),
+		                       G_VARIANT_TYPE("(v)"),
+		                       G_DBUS_CALL_FLAGS_NO_AUTO_START,
+		                       DBUS_MENU_CALL_TIMEOUT,
+		                       menu->cancellable,
+		                       version_ready_cb,
+		                       menu);
+		g_object_set(menu->top_model, "xml", proxy, NULL);
+	}
+	else if (dbus_menu_importer_check(menu))
 		g_object_set(menu->top_model, "xml", proxy, NULL);
 	g_object_notify_by_pspec(G_OBJECT(menu), properties[PROP_MODEL]);
 }
@@ -86,7 +240,8 @@ static void name_appeared_cb(GDBusConnection *connection, const char *name, cons
 	DBusMenuImporter *menu = DBUS_MENU_IMPORTER(user_data);
 
 	dbus_menu_xml_proxy_new(connection,
-	                        G_DBUS_PROXY_FLAGS_NONE,
+	                        menu->fast_connect ? G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES
+	                                           : G_DBUS_PROXY_FLAGS_NONE,
 	                        menu->bus_name,
 	                        menu->object_path,
 	                        menu->cancellable,
@@ -101,6 +256,7 @@ static void name_vanished_cb(GDBusConnection *connection, const char *name, gpoi
 	g_object_set(menu->top_model, "xml", NULL, NULL);
 	g_object_notify_by_pspec(G_OBJECT(menu), properties[PROP_MODEL]);
 	g_clear_object(&menu->proxy);
+	importer_pool_remove(menu);
 }
 
 static void dbus_menu_importer_constructed(GObject *object)
@@ -146,6 +302,15 @@ static void dbus_menu_importer_finalize(GObject *object)
 	G_OBJECT_CLASS(dbus_menu_importer_parent_class)->finalize(object);
 }
 
+// Prefetch is applied to the first layout request, so it should be set before name appears
+static void dbus_menu_importer_update_prefetch(DBusMenuImporter *menu)
+{
+	dbus_menu_model_set_prefetch(menu->top_model,
+	                             menu->prefetch_depth,
+	                             menu->prefetch_max_items,
+	                             menu->prefetch_max_bytes);
+}
+
 static void dbus_menu_importer_set_property(GObject *object, guint property_id, const GValue *value,
                                             GParamSpec *pspec)
 {
@@ -161,6 +326,25 @@ static void dbus_menu_importer_set_property(GObject *object, guint property_id,
 		menu->object_path = g_value_dup_string(value);
 		break;
 
+	case PROP_PREFETCH_DEPTH:
+		menu->prefetch_depth = g_value_get_int(value);
+		dbus_menu_importer_update_prefetch(menu);
+		break;
+
+	case PROP_PREFETCH_MAX_ITEMS:
+		menu->prefetch_max_items = g_value_get_uint(value);
+		dbus_menu_importer_update_prefetch(menu);
+		break;
+
+	case PROP_PREFETCH_MAX_BYTES:
+		menu->prefetch_max_bytes = g_value_get_uint(value);
+		dbus_menu_importer_update_prefetch(menu);
+		break;
+
+	case PROP_FAST_CONNECT:
+		menu->fast_connect = g_value_get_boolean(value);
+		break;
+
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
 		break;
@@ -179,6 +363,18 @@ static void dbus_menu_importer_get_property(GObject *object, guint property_id,
 	case PROP_ACTION_GROUP:
 		g_value_set_object(value, menu->all_actions);
 		break;
+	case PROP_PREFETCH_DEPTH:
+		g_value_set_int(value, menu->prefetch_depth);
+		break;
+	case PROP_PREFETCH_MAX_ITEMS:
+		g_value_set_uint(value, menu->prefetch_max_items);
+		break;
+	case PROP_PREFETCH_MAX_BYTES:
+		g_value_set_uint(value, menu->prefetch_max_bytes);
+		break;
+	case PROP_FAST_CONNECT:
+		g_value_set_boolean(value, menu->fast_connect);
+		break;
 
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
@@ -212,6 +408,36 @@ static void install_properties(GObjectClass *object_class)
 	                        "action-group",
 	                        G_TYPE_ACTION_GROUP,
 	                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+	properties[PROP_PREFETCH_DEPTH] =
+	    g_param_spec_int("prefetch-depth",
+	                     "prefetch-depth",
+	                     "Depth of the first layout request, -1 for the whole tree",
+	                     -1,
+	                     G_MAXINT,
+	                     1,
+	                     G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+	properties[PROP_PREFETCH_MAX_ITEMS] =
+	    g_param_spec_uint("prefetch-max-items",
+	                      "prefetch-max-items",
+	                      "Maximum number of prefetched submenu items",
+	                      0,
+	                      G_MAXUINT,
+	                      DBUS_MENU_PREFETCH_MAX_ITEMS,
+	                      G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+	properties[PROP_PREFETCH_MAX_BYTES] =
+	    g_param_spec_uint("prefetch-max-bytes",
+	                      "prefetch-max-bytes",
+	                      "Maximum size of prefetched layout",
+	                      0,
+	                      G_MAXUINT,
+	                      DBUS_MENU_PREFETCH_MAX_BYTES,
+	                      G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+	properties[PROP_FAST_CONNECT] =
+	    g_param_spec_boolean("fast-connect",
+	                         "fast-connect",
+	                         "Do not load properties, request layout together with version check",
+	                         false,
+	                         G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
 	g_object_class_install_properties(object_class, LAST_PROP, properties);
 }
@@ -229,6 +455,37 @@ static void dbus_menu_importer_class_init(DBusMenuImporterClass *menu_class)
 	object_class->get_property = dbus_menu_importer_get_property;
 
 	install_properties(object_class);
+
+	/**
+	 * DBusMenuImporter::layout-received:
+	 * @importer: the importer
+	 *
+	 * Emitted when reply to GetLayout of the root menu is received, before it is applied.
+	 */
+	signals[LAYOUT_RECEIVED_SIGNAL] = g_signal_new(g_intern_static_string("layout-received"),
+	                                               dbus_menu_importer_get_type(),
+	                                               G_SIGNAL_RUN_LAST,
+	                                               0,
+	                                               NULL,
+	                                               NULL,
+	                                               g_cclosure_marshal_VOID__VOID,
+	                                               G_TYPE_NONE,
+	                                               0);
+	/**
+	 * DBusMenuImporter::layout-applied:
+	 * @importer: the importer
+	 *
+	 * Emitted when layout of the root menu is applied to #DBusMenuImporter:model.
+	 */
+	signals[LAYOUT_APPLIED_SIGNAL]  = g_signal_new(g_intern_static_string("layout-applied"),
+	                                              dbus_menu_importer_get_type(),
+	                                              G_SIGNAL_RUN_LAST,
+	                                              0,
+	                                              NULL,
+	                                              NULL,
+	                                              g_cclosure_marshal_VOID__VOID,
+	                                              G_TYPE_NONE,
+	                                              0);
 }
 
 static void dbus_menu_importer_init(DBusMenuImporter *menu)
@@ -241,6 +498,14 @@ static void dbus_menu_importer_init(DBusMenuImporter *menu)
 	                 "items-changed",
 	                 G_CALLBACK(dbus_menu_importer_on_root_model_changed),
 	                 menu);
+	g_signal_connect(menu->top_model,
+	                 "layout-received",
+	                 G_CALLBACK(dbus_menu_importer_on_root_layout_received),
+	                 menu);
+	g_signal_connect(menu->top_model,
+	                 "layout-applied",
+	                 G_CALLBACK(dbus_menu_importer_on_root_layout_applied),
+	                 menu);
 	menu->cancellable = g_cancellable_new();
 }
 
@@ -253,3 +518,32 @@ DBusMenuImporter *dbus_menu_importer_new(const char *bus_name, const char *objec
 	                    object_path,
 	                    NULL);
 }
+
+/**
+ * dbus_menu_importer_get_cached:
+ * @bus_name: bus name of menu owner
+ * @object_path: object path of menu
+ *
+ * Returns: (transfer full): importer for the menu, reusing a recently used one with its
+ * already populated model
+ */
+DBusMenuImporter *dbus_menu_importer_get_cached(const char *bus_name, const char *object_path)
+{
+	ImporterPool *pool = importer_pool_get();
+	g_autofree char *key = g_strconcat(bus_name, " ", object_path, NULL);
+	GList *link          = (GList *)g_hash_table_lookup(pool->entries, key);
+	if (link != NULL)
+	{
+		g_queue_unlink(&pool->lru, link);
+		g_queue_push_head_link(&pool->lru, link);
+		importer_pool_trim(pool);
+		return DBUS_MENU_IMPORTER(g_object_ref(((ImporterPoolEntry *)link->data)->importer));
+	}
+	ImporterPoolEntry *entry = g_slice_new0(ImporterPoolEntry);
+	entry->key               = g_steal_pointer(&key);
+	entry->importer          = dbus_menu_importer_new(bus_name, object_path);
+	g_queue_push_head(&pool->lru, entry);
+	g_hash_table_insert(pool->entries, entry->key, pool->lru.head);
+	importer_pool_trim(pool);
+	return DBUS_MENU_IMPORTER(g_object_ref(entry->importer));
+}
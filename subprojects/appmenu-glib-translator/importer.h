@@ -27,6 +27,7 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE(DBusMenuImporter, dbus_menu_importer, DBUS_MENU, IMPORTER, GObject)
 
 DBusMenuImporter *dbus_menu_importer_new(const char *bus_name, const char *object_path);
+DBusMenuImporter *dbus_menu_importer_get_cached(const char *bus_name, const char *object_path);
 
 G_END_DECLS
 
@@ -1,22 +1,17 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gio/gio.h>
 
-G_GNUC_INTERNAL GIcon *g_icon_new_pixbuf_from_variant(GVariant *variant)
+// Oversized icon data is decoded once and scaled down to the menu icon size
+static GVariant *icon_serialize_scaled(GBytes *bytes, int size)
 {
-	gsize length;
-	const unsigned char *data =
-	    (const unsigned char *)g_variant_get_fixed_array(variant, &length, sizeof(guchar));
-	if (length == 0)
-		return NULL;
-
-	g_autoptr(GInputStream) stream = g_memory_input_stream_new_from_data(data, length, NULL);
-	if (stream == NULL)
-		return NULL;
-
-	g_autoptr(GError) error = NULL;
-	GdkPixbuf *pixbuf       = gdk_pixbuf_new_from_stream(stream, NULL, &error);
+	g_autoptr(GInputStream) stream = g_memory_input_stream_new_from_bytes(bytes);
+	g_autoptr(GError) error        = NULL;
+	g_autoptr(GdkPixbuf) pixbuf =
+	    gdk_pixbuf_new_from_stream_at_scale(stream, size, size, true, NULL, &error);
 	if (error != NULL)
+	{
 		g_warning("Unable to build GdkPixbuf from icon data: %s", error->message);
-
-	return G_ICON(pixbuf);
+		return NULL;
+	}
+	return g_icon_serialize(G_ICON(pixbuf));
 }
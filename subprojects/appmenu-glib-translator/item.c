@@ -20,6 +20,7 @@
 
 #include "dbusmenu-interface.h"
 #include "definitions.h"
+#include "icon-cache.h"
 #include "item.h"
 #include "utils.h"
 
@@ -32,12 +33,98 @@
 G_GNUC_INTERNAL void dbus_menu_item_free(gpointer data);
 G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_copy(DBusMenuItem *src);
 G_DEFINE_BOXED_TYPE(DBusMenuItem, dbus_menu_item, dbus_menu_item_copy, dbus_menu_item_free)
-#if 0
-#include "item-pixbuf.c"
-#endif
 
 static void act_props_try_update(DBusMenuItem *item);
 
+static const char *attr_names[DBUS_MENU_ITEM_N_ATTRS] = {
+	[DBUS_MENU_ITEM_ATTR_LABEL]          = G_MENU_ATTRIBUTE_LABEL,
+	[DBUS_MENU_ITEM_ATTR_ACTION]         = G_MENU_ATTRIBUTE_ACTION,
+	[DBUS_MENU_ITEM_ATTR_TARGET]         = G_MENU_ATTRIBUTE_TARGET,
+	[DBUS_MENU_ITEM_ATTR_ACCEL]          = G_MENU_ATTRIBUTE_ACCEL,
+	[DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN]    = G_MENU_ATTRIBUTE_HIDDEN_WHEN,
+	[DBUS_MENU_ITEM_ATTR_SUBMENU_ACTION] = G_MENU_ATTRIBUTE_SUBMENU_ACTION,
+	[DBUS_MENU_ITEM_ATTR_ICON]           = G_MENU_ATTRIBUTE_ICON,
+	[DBUS_MENU_ITEM_ATTR_VERB_ICON]      = G_MENU_ATTRIBUTE_VERB_ICON,
+};
+
+typedef enum
+{
+	ATTR_CONST_EMPTY,
+	ATTR_CONST_DISABLED_ACTION,
+	ATTR_CONST_RADIO_SELECTED,
+	ATTR_CONST_HIDDEN_WHEN_MISSING,
+	ATTR_CONST_N
+} AttrConst;
+
+static const char *attr_const_strings[ATTR_CONST_N] = {
+	[ATTR_CONST_EMPTY]               = "",
+	[ATTR_CONST_DISABLED_ACTION]     = DBUS_MENU_DISABLED_ACTION,
+	[ATTR_CONST_RADIO_SELECTED]      = DBUS_MENU_ACTION_RADIO_SELECTED,
+	[ATTR_CONST_HIDDEN_WHEN_MISSING] = G_MENU_HIDDEN_WHEN_ACTION_MISSING,
+};
+
+// Values which are the same for many items are created once and shared. Returned
+// reference is borrowed.
+static GVariant *attr_const(AttrConst idx)
+{
+	static GVariant *values[ATTR_CONST_N] = { NULL };
+	if (g_once_init_enter(&values[idx]))
+		g_once_init_leave(&values[idx],
+		                  g_variant_ref_sink(g_variant_new_string(attr_const_strings[idx])));
+	return values[idx];
+}
+
+static GVariant *attr_get(DBusMenuItem *item, DBusMenuItemAttr attr)
+{
+	if (item->lazy_attrs & (1u << attr))
+	{
+		DBusMenuActionType type = attr == DBUS_MENU_ITEM_ATTR_SUBMENU_ACTION
+		                              ? DBUS_MENU_ACTION_SUBMENU
+		                              : item->action_type;
+		g_autofree char *name = dbus_menu_action_get_name(item->id, type, true);
+		item->attrs[attr]     = g_variant_ref_sink(g_variant_new_string(name));
+		item->lazy_attrs &= ~(1u << attr);
+	}
+	return item->attrs[attr];
+}
+
+// Floating value is sunk, otherwise a new reference is taken. NULL removes attribute.
+static void attr_set(DBusMenuItem *item, DBusMenuItemAttr attr, GVariant *value)
+{
+	GVariant *old = item->attrs[attr];
+	g_clear_pointer(&item->attr_table, g_hash_table_unref);
+	item->lazy_attrs &= ~(1u << attr);
+	item->attrs[attr] = value != NULL ? g_variant_ref_sink(value) : NULL;
+	if (old != NULL)
+		g_variant_unref(old);
+}
+
+static void attr_set_action_name(DBusMenuItem *item, DBusMenuItemAttr attr)
+{
+	attr_set(item, attr, NULL);
+	item->lazy_attrs |= 1u << attr;
+}
+
+static bool attr_is_set(DBusMenuItem *item, DBusMenuItemAttr attr)
+{
+	return item->attrs[attr] != NULL || (item->lazy_attrs & (1u << attr));
+}
+
+static bool attr_has_string(DBusMenuItem *item, DBusMenuItemAttr attr, const char *str)
+{
+	GVariant *value = attr_get(item, attr);
+	return value != NULL && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING) &&
+	       !g_strcmp0(g_variant_get_string(value, NULL), str);
+}
+
+static void attr_clear_all(DBusMenuItem *item)
+{
+	g_clear_pointer(&item->attr_table, g_hash_table_unref);
+	for (uint i = 0; i < DBUS_MENU_ITEM_N_ATTRS; i++)
+		g_clear_pointer(&item->attrs[i], g_variant_unref);
+	item->lazy_attrs = 0;
+}
+
 G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_new_first_section(u_int32_t id,
                                                                GActionGroup *action_group)
 {
@@ -46,8 +133,6 @@ G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_new_first_section(u_int32_t id,
 	item->action_type  = DBUS_MENU_ACTION_SECTION;
 	item->enabled      = false;
 	item->toggled      = false;
-	item->attrs =
-	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
 	item->links = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_object_unref);
 	item->ref_action_group = action_group;
 	item_set_magic(item);
@@ -66,9 +151,7 @@ G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_new(u_int32_t id, DBusMenuModel *pa
 	item->enabled = true;
 	item->toggled = false;
 	item->id      = id;
-	item->attrs =
-	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
-	item->links = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_object_unref);
+	item->links   = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_object_unref);
 	g_object_get(parent_model, "action-group", &item->ref_action_group, "xml", &xml, NULL);
 	g_variant_iter_init(&iter, props);
 	// Iterate by immutable properties, it is construct_only
@@ -79,46 +162,34 @@ G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_new(u_int32_t id, DBusMenuModel *pa
 		{
 			if (value == NULL)
 			{
-				g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_SUBMENU_ACTION);
+				attr_set(item, DBUS_MENU_ITEM_ATTR_SUBMENU_ACTION, NULL);
 				continue;
 			}
 			else if (g_strcmp0(g_variant_get_string(value, NULL),
 			                   DBUS_MENU_CHILDREN_DISPLAY_SUBMENU) == 0)
 			{
 				item->action_type = DBUS_MENU_ACTION_SUBMENU;
-				g_autofree char *name =
-				    dbus_menu_action_get_name(id, item->action_type, true);
-				g_hash_table_insert(item->attrs,
-				                    g_strdup(G_MENU_ATTRIBUTE_SUBMENU_ACTION),
-				                    g_variant_new_string(name));
+				attr_set_action_name(item, DBUS_MENU_ITEM_ATTR_SUBMENU_ACTION);
 				action_creator_found = true;
 			}
 		}
 		else if (g_strcmp0(prop, DBUS_MENU_PROP_TOGGLE_TYPE) == 0)
 		{
-			g_autofree char *name =
-			    dbus_menu_action_get_name(id, item->action_type, true);
 			if (g_strcmp0(g_variant_get_string(value, NULL),
 			              DBUS_MENU_TOGGLE_TYPE_CHECK) == 0)
 			{
 				item->action_type = DBUS_MENU_ACTION_CHECKMARK;
-				g_hash_table_insert(item->attrs,
-				                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-				                    g_variant_new_string(name));
+				attr_set_action_name(item, DBUS_MENU_ITEM_ATTR_ACTION);
 				action_creator_found = true;
 			}
 			else if (g_strcmp0(g_variant_get_string(value, NULL),
 			                   DBUS_MENU_TOGGLE_TYPE_RADIO) == 0)
 			{
 				item->action_type = DBUS_MENU_ACTION_RADIO;
-				g_hash_table_insert(item->attrs,
-				                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-				                    g_variant_new_string(name));
-				GVariant *vstr =
-				    g_variant_new_string(DBUS_MENU_ACTION_RADIO_SELECTED);
-				g_hash_table_insert(item->attrs,
-				                    g_strdup(G_MENU_ATTRIBUTE_TARGET),
-				                    g_variant_ref_sink(vstr));
+				attr_set_action_name(item, DBUS_MENU_ITEM_ATTR_ACTION);
+				attr_set(item,
+				         DBUS_MENU_ITEM_ATTR_TARGET,
+				         attr_const(ATTR_CONST_RADIO_SELECTED));
 				action_creator_found = true;
 			}
 		}
@@ -133,35 +204,25 @@ G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_new(u_int32_t id, DBusMenuModel *pa
 			else if (!g_strcmp0(type, DBUS_MENU_TYPE_NORMAL))
 			{
 				item->action_type = DBUS_MENU_ACTION_NORMAL;
-				g_autofree char *name =
-				    dbus_menu_action_get_name(id, item->action_type, true);
-				g_hash_table_insert(item->attrs,
-				                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-				                    g_variant_new_string(name));
+				attr_set_action_name(item, DBUS_MENU_ITEM_ATTR_ACTION);
 				action_creator_found = true;
 			}
 		}
 		else if (g_strcmp0(prop, "x-kde-title") == 0)
 		{
 			item->action_type = DBUS_MENU_ACTION_SECTION;
-			g_hash_table_insert(item->attrs, g_strdup(G_MENU_ATTRIBUTE_LABEL), value);
+			attr_set(item, DBUS_MENU_ITEM_ATTR_LABEL, value);
 			action_creator_found = true;
 		}
 		else if (!action_creator_found)
 		{
 			item->action_type = DBUS_MENU_ACTION_NORMAL;
-			g_autofree char *name =
-			    dbus_menu_action_get_name(id, item->action_type, true);
-			g_hash_table_insert(item->attrs,
-			                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-			                    g_variant_new_string(name));
+			attr_set_action_name(item, DBUS_MENU_ITEM_ATTR_ACTION);
 			action_creator_found = true;
 		}
 	}
 	if (item->action_type != DBUS_MENU_ACTION_SECTION)
-		g_hash_table_insert(item->attrs,
-		                    g_strdup(G_MENU_ATTRIBUTE_LABEL),
-		                    g_variant_new_string(""));
+		attr_set(item, DBUS_MENU_ITEM_ATTR_LABEL, attr_const(ATTR_CONST_EMPTY));
 	dbus_menu_item_update_props(item, props);
 	return item;
 }
@@ -171,11 +232,14 @@ G_GNUC_INTERNAL void dbus_menu_item_free(gpointer data)
 	DBusMenuItem *item = (DBusMenuItem *)data;
 	if (item == NULL)
 		return;
+	if (item->parent_model != NULL)
+		dbus_menu_model_unindex_item(item->parent_model, item);
 	item->magic = NULL;
-	g_clear_pointer(&item->attrs, g_hash_table_destroy);
+	attr_clear_all(item);
+	g_clear_pointer(&item->data_icon, g_variant_unref);
 	g_clear_pointer(&item->links, g_hash_table_destroy);
 	g_clear_object(&item->ref_action);
-	g_source_remove_by_user_data(item);
+	dbus_menu_event_prefetch_cancel(item);
 	g_slice_free(DBusMenuItem, data);
 }
 
@@ -186,79 +250,113 @@ G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_copy(DBusMenuItem *src)
 	dst->action_type      = src->action_type;
 	dst->enabled          = src->enabled;
 	dst->toggled          = src->toggled;
+	dst->has_icon_name    = src->has_icon_name;
+	dst->data_icon        = src->data_icon != NULL ? g_variant_ref(src->data_icon) : NULL;
 	dst->ref_action       = G_ACTION(g_object_ref(src->ref_action));
 	dst->ref_action_group = src->ref_action_group;
-	dst->attrs            = g_hash_table_ref(src->attrs);
-	dst->links            = g_hash_table_ref(src->links);
+	for (uint i = 0; i < DBUS_MENU_ITEM_N_ATTRS; i++)
+		if (src->attrs[i] != NULL)
+			dst->attrs[i] = g_variant_ref(src->attrs[i]);
+	dst->lazy_attrs = src->lazy_attrs;
+	dst->links      = g_hash_table_ref(src->links);
 	return dst;
 }
 
-static bool attr_update_checked(DBusMenuItem *item, const char *key, GVariant *value)
+static bool attr_update_checked(DBusMenuItem *item, DBusMenuItemAttr attr, GVariant *value)
 {
-	GVariant *old  = (GVariant *)g_hash_table_lookup(item->attrs, key);
-	bool are_equal = false;
-	if (old != NULL)
-		are_equal = g_variant_equal(old, value);
-	if (!are_equal)
+	GVariant *old = attr_get(item, attr);
+	// Shared values are usually the same pointer
+	if (old != NULL && (old == value || g_variant_equal(old, value)))
+		return false;
+	attr_set(item, attr, value);
+	return true;
+}
+
+// Icons come from cache, so the same icon is the same variant
+static bool attr_update_icon(DBusMenuItem *item, GVariant *icon)
+{
+	if (item->attrs[DBUS_MENU_ITEM_ATTR_ICON] == icon)
+		return false;
+	attr_set(item, DBUS_MENU_ITEM_ATTR_ICON, icon);
+	attr_set(item, DBUS_MENU_ITEM_ATTR_VERB_ICON, icon);
+	return true;
+}
+
+G_GNUC_INTERNAL GVariant *dbus_menu_item_get_attribute(DBusMenuItem *item, const char *name,
+                                                       const GVariantType *expected_type)
+{
+	for (uint i = 0; i < DBUS_MENU_ITEM_N_ATTRS; i++)
 	{
-		g_hash_table_insert(item->attrs, g_strdup(key), g_variant_ref_sink(value));
-		return true;
+		if (g_strcmp0(name, attr_names[i]) != 0)
+			continue;
+		GVariant *value = attr_get(item, i);
+		if (value == NULL)
+			return NULL;
+		if (expected_type != NULL && !g_variant_is_of_type(value, expected_type))
+			return NULL;
+		return g_variant_ref(value);
 	}
-	return false;
+	return NULL;
+}
+
+// Table is built only for callers which iterate over all attributes, and kept until an
+// attribute changes. Caller owns the returned reference.
+G_GNUC_INTERNAL GHashTable *dbus_menu_item_get_attributes(DBusMenuItem *item)
+{
+	if (item->attr_table != NULL)
+		return g_hash_table_ref(item->attr_table);
+	GHashTable *table =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_variant_unref);
+	for (uint i = 0; i < DBUS_MENU_ITEM_N_ATTRS; i++)
+	{
+		GVariant *value = attr_get(item, i);
+		if (value != NULL)
+			g_hash_table_insert(table, (gpointer)attr_names[i], g_variant_ref(value));
+	}
+	item->attr_table = table;
+	return g_hash_table_ref(table);
 }
 
 G_GNUC_INTERNAL bool dbus_menu_item_is_firefox_stub(DBusMenuItem *item)
 {
-	const char *hidden_when =
-	    (const char *)g_hash_table_lookup(item->attrs, G_MENU_ATTRIBUTE_HIDDEN_WHEN);
-	const char *action =
-	    (const char *)g_hash_table_lookup(item->attrs, G_MENU_ATTRIBUTE_ACTION);
-	const char *label = (const char *)g_hash_table_lookup(item->attrs, G_MENU_ATTRIBUTE_LABEL);
-	if (!g_strcmp0(hidden_when, G_MENU_HIDDEN_WHEN_ACTION_MISSING) &&
-	    !g_strcmp0(action, DBUS_MENU_DISABLED_ACTION) && !g_strcmp0(label, "Label Empty"))
+	if (attr_has_string(item, DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN, G_MENU_HIDDEN_WHEN_ACTION_MISSING) &&
+	    attr_has_string(item, DBUS_MENU_ITEM_ATTR_ACTION, DBUS_MENU_DISABLED_ACTION) &&
+	    attr_has_string(item, DBUS_MENU_ITEM_ATTR_LABEL, "Label Empty"))
 		return true;
 	return false;
 }
 
+G_GNUC_INTERNAL DBusMenuModel *dbus_menu_item_get_submenu(DBusMenuItem *item)
+{
+	if (item->action_type != DBUS_MENU_ACTION_SUBMENU)
+		return NULL;
+	gpointer submenu = g_hash_table_lookup(item->links, submenu_str(item->enabled));
+	return DBUS_MENU_IS_MODEL(submenu) ? DBUS_MENU_MODEL(submenu) : NULL;
+}
+
 G_GNUC_INTERNAL void dbus_menu_item_preload(DBusMenuItem *item)
 {
 	if (!item_check_magic(item))
 		return;
-	if (item->action_type != DBUS_MENU_ACTION_SUBMENU)
-		return;
-	int id;
-	DBusMenuXml *xml = NULL;
-	bool need_update;
-	DBusMenuModel *submenu =
-	    DBUS_MENU_MODEL(g_hash_table_lookup(item->links, submenu_str(item->enabled)));
-	if (!submenu || !DBUS_MENU_IS_MODEL(submenu))
+	g_autoptr(DBusMenuXml) xml = NULL;
+	DBusMenuModel *submenu     = dbus_menu_item_get_submenu(item);
+	if (!submenu)
 		return;
-	g_object_get(submenu, "parent-id", &id, "xml", &xml, NULL);
+	g_object_get(submenu, "xml", &xml, NULL);
 	if (!xml || !DBUS_MENU_IS_XML(xml))
 		return;
-	dbus_menu_xml_call_event_sync(xml,
-	                              id,
-	                              "opened",
-	                              g_variant_new("v", g_variant_new_int32(0)),
-	                              CURRENT_TIME,
-	                              NULL,
-	                              NULL);
-	dbus_menu_xml_call_about_to_show_sync(xml, id, (gboolean *)&need_update, NULL, NULL);
-	need_update = need_update || dbus_menu_model_is_layout_update_required(submenu);
-	if (need_update)
-		dbus_menu_model_update_layout(submenu);
+	// Submenus are collected and preloaded in one batch
+	dbus_menu_event_prefetch(xml, item, submenu);
 }
 
-G_GNUC_INTERNAL bool dbus_menu_item_copy_attrs(DBusMenuItem *src, DBusMenuItem *dst)
+G_GNUC_INTERNAL bool dbus_menu_item_copy_attributes(DBusMenuItem *src, DBusMenuItem *dst)
 {
-	GHashTableIter iter;
-	g_hash_table_iter_init(&iter, src->attrs);
 	bool is_updated = false;
-	char *key;
-	GVariant *value;
-	while (g_hash_table_iter_next(&iter, (void **)&key, (void **)&value))
+	for (uint i = 0; i < DBUS_MENU_ITEM_N_ATTRS; i++)
 	{
-		is_updated = attr_update_checked(dst, key, value) || is_updated;
+		GVariant *value = attr_get(src, i);
+		if (value != NULL)
+			is_updated = attr_update_checked(dst, i, value) || is_updated;
 	}
 	return is_updated;
 }
@@ -280,14 +378,13 @@ G_GNUC_INTERNAL bool dbus_menu_item_update_enabled(DBusMenuItem *item, bool enab
 			}
 			if (enabled)
 			{
-				g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_ACTION);
+				attr_set(item, DBUS_MENU_ITEM_ATTR_ACTION, NULL);
 			}
 			else
 			{
-				g_hash_table_insert(item->attrs,
-				                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-				                    g_variant_new_string(
-				                        DBUS_MENU_DISABLED_ACTION));
+				attr_set(item,
+				         DBUS_MENU_ITEM_ATTR_ACTION,
+				         attr_const(ATTR_CONST_DISABLED_ACTION));
 			}
 			updated = true;
 		}
@@ -346,7 +443,7 @@ static bool dbus_menu_item_update_shortcut(DBusMenuItem *item, GVariant *value)
 	g_variant_unref(child);
 	g_autofree char *str = g_string_free(new_accel_string, false);
 	GVariant *new_accel  = g_variant_new_string(str);
-	bool updated         = attr_update_checked(item, G_MENU_ATTRIBUTE_ACCEL, new_accel);
+	bool updated = attr_update_checked(item, DBUS_MENU_ITEM_ATTR_ACCEL, new_accel);
 	if (!updated)
 		g_variant_unref(new_accel);
 	return updated;
@@ -357,7 +454,9 @@ G_GNUC_INTERNAL bool dbus_menu_item_update_props(DBusMenuItem *item, GVariant *p
 	GVariantIter iter;
 	const char *prop;
 	GVariant *value;
-	bool properties_is_updated = false;
+	g_autoptr(GVariant) icon_name = NULL;
+	g_autoptr(GVariant) icon_data = NULL;
+	bool properties_is_updated    = false;
 
 	g_variant_iter_init(&iter, props);
 	while (g_variant_iter_loop(&iter, "{&sv}", &prop, &value))
@@ -373,49 +472,21 @@ G_GNUC_INTERNAL bool dbus_menu_item_update_props(DBusMenuItem *item, GVariant *p
 			properties_is_updated =
 			    dbus_menu_item_update_enabled(item, enabled) || properties_is_updated;
 		}
-#if 0
 		else if (g_strcmp0(prop, "icon-data") == 0)
 		{
-			// icon-name has more priority
-            if (!g_hash_table_lookup(item->attrs, G_MENU_ATTRIBUTE_ICON))
-			{
-				g_autoptr(GIcon) icon = g_icon_new_pixbuf_from_variant(value);
-				GVariant *value       = g_icon_serialize(icon);
-				properties_is_updated =
-				    properties_is_updated ||
-                    attr_update_checked(item,
-				                                       G_MENU_ATTRIBUTE_ICON,
-				                                       value);
-				properties_is_updated =
-				    properties_is_updated ||
-                    attr_update_checked(item,
-				                                       G_MENU_ATTRIBUTE_VERB_ICON,
-				                                       value);
-			}
+			// Applied after the loop, as icon-name has more priority
+			g_clear_pointer(&icon_data, g_variant_unref);
+			icon_data = g_variant_ref(value);
 		}
 		else if (g_strcmp0(prop, "icon-name") == 0)
 		{
-			g_autoptr(GIcon) icon =
-			    g_themed_icon_new(g_variant_get_string(value, NULL));
-			GVariant *value             = g_icon_serialize(icon);
-			g_autoptr(GVariant) boolvar = g_variant_new_boolean(true);
-			properties_is_updated =
-			    properties_is_updated ||
-                attr_update_checked(item, G_MENU_ATTRIBUTE_ICON, value);
-			properties_is_updated =
-			    properties_is_updated ||
-                attr_update_checked(item,
-			                                       G_MENU_ATTRIBUTE_VERB_ICON,
-			                                       value);
-			properties_is_updated =
-			    properties_is_updated ||
-                attr_update_checked(item, HAS_ICON_NAME, boolvar);
+			g_clear_pointer(&icon_name, g_variant_unref);
+			icon_name = g_variant_ref(value);
 		}
-#endif
 		else if (g_strcmp0(prop, "label") == 0)
 		{
 			properties_is_updated =
-			    attr_update_checked(item, G_MENU_ATTRIBUTE_LABEL, value) ||
+			    attr_update_checked(item, DBUS_MENU_ITEM_ATTR_LABEL, value) ||
 			    properties_is_updated;
 		}
 		else if (g_strcmp0(prop, "shortcut") == 0)
@@ -437,32 +508,23 @@ G_GNUC_INTERNAL bool dbus_menu_item_update_props(DBusMenuItem *item, GVariant *p
 			}
 			else if (vis)
 			{
-				g_autofree char *name =
-				    dbus_menu_action_get_name(item->id, item->action_type, true);
-				bool found =
-				    g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_HIDDEN_WHEN);
-				if (found)
+				if (attr_is_set(item, DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN))
 				{
-					g_hash_table_insert(item->attrs,
-					                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-					                    g_variant_new_string(name));
+					attr_set(item, DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN, NULL);
+					attr_set_action_name(item, DBUS_MENU_ITEM_ATTR_ACTION);
 					properties_is_updated = true;
 				}
 			}
 			else
 			{
-				bool found = g_hash_table_contains(item->attrs,
-				                                   G_MENU_ATTRIBUTE_HIDDEN_WHEN);
-				if (!found)
+				if (!attr_is_set(item, DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN))
 				{
-					g_hash_table_insert(item->attrs,
-					                    g_strdup(G_MENU_ATTRIBUTE_HIDDEN_WHEN),
-					                    g_variant_new_string(
-					                        G_MENU_HIDDEN_WHEN_ACTION_MISSING));
-					g_hash_table_insert(item->attrs,
-					                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-					                    g_variant_new_string(
-					                        DBUS_MENU_DISABLED_ACTION));
+					attr_set(item,
+					         DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN,
+					         attr_const(ATTR_CONST_HIDDEN_WHEN_MISSING));
+					attr_set(item,
+					         DBUS_MENU_ITEM_ATTR_ACTION,
+					         attr_const(ATTR_CONST_DISABLED_ACTION));
 					properties_is_updated = true;
 				}
 			}
@@ -472,6 +534,25 @@ G_GNUC_INTERNAL bool dbus_menu_item_update_props(DBusMenuItem *item, GVariant *p
 			g_debug("updating unsupported property - '%s'", prop);
 		}
 	}
+	if (icon_data != NULL)
+	{
+		g_clear_pointer(&item->data_icon, g_variant_unref);
+		item->data_icon = dbus_menu_icon_cache_lookup_data(icon_data);
+		if (!item->has_icon_name)
+			properties_is_updated =
+			    attr_update_icon(item, item->data_icon) || properties_is_updated;
+	}
+	if (icon_name != NULL)
+	{
+		g_autoptr(GVariant) icon =
+		    dbus_menu_icon_cache_lookup_name(g_variant_get_string(icon_name, NULL));
+		// Empty or unknown name keeps the icon from icon-data
+		if (icon != NULL || item->has_icon_name)
+			properties_is_updated =
+			    attr_update_icon(item, icon != NULL ? icon : item->data_icon) ||
+			    properties_is_updated;
+		item->has_icon_name = icon != NULL;
+	}
 	return properties_is_updated;
 }
 
@@ -496,41 +577,34 @@ G_GNUC_INTERNAL bool dbus_menu_item_remove_props(DBusMenuItem *item, GVariant *p
 		}
 		else if (g_strcmp0(prop, "icon-name") == 0)
 		{
-			if (g_hash_table_lookup(item->attrs, HAS_ICON_NAME))
+			if (item->has_icon_name)
 			{
-				g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_ICON);
-				g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_VERB_ICON);
-				g_hash_table_remove(item->attrs, HAS_ICON_NAME);
-				properties_is_updated = true;
+				item->has_icon_name = false;
+				properties_is_updated =
+				    attr_update_icon(item, item->data_icon) || properties_is_updated;
 			}
 		}
 		else if (g_strcmp0(prop, "icon-data") == 0)
 		{
-			if (!g_hash_table_lookup(item->attrs, HAS_ICON_NAME))
-			{
-				g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_ICON);
-				g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_VERB_ICON);
-				properties_is_updated = true;
-			}
+			g_clear_pointer(&item->data_icon, g_variant_unref);
+			if (!item->has_icon_name)
+				properties_is_updated =
+				    attr_update_icon(item, NULL) || properties_is_updated;
 		}
 		else if (g_strcmp0(prop, "label") == 0)
 		{
-			g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_LABEL);
+			attr_set(item, DBUS_MENU_ITEM_ATTR_LABEL, NULL);
 			properties_is_updated = true;
 		}
 		else if (g_strcmp0(prop, "shortcut") == 0)
 		{
-			g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_ACCEL);
+			attr_set(item, DBUS_MENU_ITEM_ATTR_ACCEL, NULL);
 			properties_is_updated = true;
 		}
 		else if (g_strcmp0(prop, "visible") == 0)
 		{
-			g_autofree char *name =
-			    dbus_menu_action_get_name(item->id, item->action_type, false);
-			g_hash_table_remove(item->attrs, G_MENU_ATTRIBUTE_HIDDEN_WHEN);
-			g_hash_table_insert(item->attrs,
-			                    g_strdup(G_MENU_ATTRIBUTE_ACTION),
-			                    g_variant_new_string(name));
+			attr_set(item, DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN, NULL);
+			attr_set_action_name(item, DBUS_MENU_ITEM_ATTR_ACTION);
 			properties_is_updated = true;
 		}
 		else
@@ -27,21 +27,47 @@
 
 G_BEGIN_DECLS
 
-typedef struct
+// Attributes which items can have. Values are kept in fixed slots, so no per-item hash
+// table is needed for them.
+typedef enum
+{
+	DBUS_MENU_ITEM_ATTR_LABEL,
+	DBUS_MENU_ITEM_ATTR_ACTION,
+	DBUS_MENU_ITEM_ATTR_TARGET,
+	DBUS_MENU_ITEM_ATTR_ACCEL,
+	DBUS_MENU_ITEM_ATTR_HIDDEN_WHEN,
+	DBUS_MENU_ITEM_ATTR_SUBMENU_ACTION,
+	DBUS_MENU_ITEM_ATTR_ICON,
+	DBUS_MENU_ITEM_ATTR_VERB_ICON,
+	DBUS_MENU_ITEM_N_ATTRS
+} DBusMenuItemAttr;
+
+struct _DBusMenuItem
 {
 	int section_num;
 	int place;
 	u_int32_t id;
+	// Unowned. Model whose index references this item, NULL for detached items
+	DBusMenuModel *parent_model;
 	GActionGroup *ref_action_group;
 	// FIXME: Cannot have activatable submenu item.
 	GAction *ref_action;
-	GHashTable *attrs;
+	GVariant *attrs[DBUS_MENU_ITEM_N_ATTRS];
+	// Slots which hold default action name, it is formatted on first access
+	u_int32_t lazy_attrs;
+	// Table from dbus_menu_item_get_attributes(), dropped when any attribute changes
+	GHashTable *attr_table;
 	GHashTable *links;
 	DBusMenuActionType action_type;
 	bool enabled;
 	bool toggled;
+	bool has_icon_name;
+	// Icon from icon-data property, shown when icon-name is missing or not found
+	GVariant *data_icon;
+	// Entry in the prefetch queue of the client, NULL if submenu is not queued
+	gpointer prefetch;
 	gpointer magic;
-} DBusMenuItem;
+};
 
 G_GNUC_INTERNAL DBusMenuItem *dbus_menu_item_new(u_int32_t id, DBusMenuModel *parent_model,
                                                  GVariant *props);
@@ -60,6 +86,11 @@ G_GNUC_INTERNAL bool dbus_menu_item_compare_immutable(DBusMenuItem *a, DBusMenuI
 
 G_GNUC_INTERNAL bool dbus_menu_item_copy_attributes(DBusMenuItem *src, DBusMenuItem *dst);
 
+G_GNUC_INTERNAL GVariant *dbus_menu_item_get_attribute(DBusMenuItem *item, const char *name,
+                                                       const GVariantType *expected_type);
+
+G_GNUC_INTERNAL GHashTable *dbus_menu_item_get_attributes(DBusMenuItem *item);
+
 G_GNUC_INTERNAL bool dbus_menu_item_is_firefox_stub(DBusMenuItem *item);
 
 G_GNUC_INTERNAL void dbus_menu_item_copy_submenu(DBusMenuItem *src, DBusMenuItem *dst,
@@ -67,6 +98,8 @@ G_GNUC_INTERNAL void dbus_menu_item_copy_submenu(DBusMenuItem *src, DBusMenuItem
 
 G_GNUC_INTERNAL void dbus_menu_item_generate_action(DBusMenuItem *item, DBusMenuModel *parent);
 
+G_GNUC_INTERNAL DBusMenuModel *dbus_menu_item_get_submenu(DBusMenuItem *item);
+
 G_GNUC_INTERNAL void dbus_menu_item_preload(DBusMenuItem *item);
 
 G_GNUC_INTERNAL int dbus_menu_item_id_compare_func(const DBusMenuItem *a, gconstpointer b,
@@ -29,14 +29,29 @@ struct _DBusMenuModel
 	GMenuModel parent_instance;
 
 	uint parent_id;
+	// Id of the menu which holds the item of this submenu, UINT_MAX for toplevel
+	uint owner_id;
 	uint current_revision;
 	GCancellable *cancellable;
 	DBusMenuXml *xml;
 	GActionGroup *received_action_group;
 	GSequence *items;
+	// Index over items: id -> item, and section_num -> array of items, where
+	// slot 0 is a section item and slot place + 1 is an item on that place
+	GHashTable *items_by_id;
+	GPtrArray *sections;
 	GVariant *current_layout;
 	bool layout_update_required;
 	uint parse_pending;
+	// Depth of a layout which is requested first, and budget for nested layouts which are
+	// fed into submenus from it. Depth of the current request is kept for parsing.
+	int prefetch_depth;
+	uint prefetch_max_items;
+	uint prefetch_max_bytes;
+	int requested_depth;
+	// Ids of items which properties should be refreshed in one batch
+	GHashTable *pending_props;
+	uint props_pending;
 };
 
 static const char *property_names[] = { "accessible-desc",
@@ -63,51 +78,71 @@ enum
 
 static GParamSpec *properties[NUM_PROPS] = { NULL };
 
+enum
+{
+	LAYOUT_RECEIVED_SIGNAL,
+	LAYOUT_APPLIED_SIGNAL,
+	NUM_SIGNALS
+};
+
+static uint signals[NUM_SIGNALS] = { 0 };
+
+// Upper bound of LCS table size for one section diff
+#define LAYOUT_DIFF_MAX_CELLS (1 << 20)
+
 static DBusMenuItem *dbus_menu_model_find(DBusMenuModel *menu, uint item_id);
 static DBusMenuItem *dbus_menu_model_find_section(DBusMenuModel *menu, uint section_num);
+static DBusMenuItem *dbus_menu_model_find_item(DBusMenuModel *menu, uint section_num, int place);
 static GSequenceIter *dbus_menu_model_find_place(DBusMenuModel *menu, uint section_num, int place);
+static int dbus_menu_model_sort_func(gconstpointer a, gconstpointer b,
+                                     G_GNUC_UNUSED void *user_data);
+static void items_properties_loop(DBusMenuModel *menu, GVariant *up_props, GQueue *signal_queue,
+                                  bool is_removal);
+
+struct layout_budget
+{
+	// Depth of received items. 1 means that their children were not requested, and
+	// negative one means the whole tree.
+	int depth;
+	uint items_left;
+};
+
+static void layout_apply(DBusMenuModel *menu, GVariant *items, struct layout_budget *budget);
 
 G_DEFINE_TYPE(DBusMenuModel, dbus_menu_model, G_TYPE_MENU_MODEL)
 
 static gint dbus_menu_model_get_n_items(GMenuModel *model)
 {
-	DBusMenuModel *menu      = (DBusMenuModel *)(model);
-	GSequenceIter *last_iter = g_sequence_iter_prev(g_sequence_get_end_iter(menu->items));
-	DBusMenuItem *last       = g_sequence_get(last_iter);
-	return last->section_num + 1;
+	DBusMenuModel *menu = (DBusMenuModel *)(model);
+	return menu->sections->len;
 }
 
 static void dbus_menu_model_get_item_attributes(GMenuModel *model, gint position,
                                                 GHashTable **table)
 {
 	DBusMenuModel *menu = DBUS_MENU_MODEL(model);
-	for (GSequenceIter *iter = g_sequence_get_begin_iter(menu->items);
-	     !g_sequence_iter_is_end(iter);
-	     iter = g_sequence_iter_next(iter))
-	{
-		DBusMenuItem *item = (DBusMenuItem *)g_sequence_get(iter);
-		if (item->section_num == position && item->place == -1)
-		{
-			*table = g_hash_table_ref(item->attrs);
-			return;
-		}
-	}
+	DBusMenuItem *item  = dbus_menu_model_find_section(menu, position);
+	if (item != NULL)
+		*table = dbus_menu_item_get_attributes(item);
+}
+
+static GVariant *dbus_menu_model_get_item_attribute_value(GMenuModel *model, gint position,
+                                                          const char *attribute,
+                                                          const GVariantType *expected_type)
+{
+	DBusMenuModel *menu = DBUS_MENU_MODEL(model);
+	DBusMenuItem *item  = dbus_menu_model_find_section(menu, position);
+	if (item == NULL)
+		return NULL;
+	return dbus_menu_item_get_attribute(item, attribute, expected_type);
 }
 
 static void dbus_menu_model_get_item_links(GMenuModel *model, gint position, GHashTable **table)
 {
 	DBusMenuModel *menu = DBUS_MENU_MODEL(model);
-	for (GSequenceIter *iter = g_sequence_get_begin_iter(menu->items);
-	     !g_sequence_iter_is_end(iter);
-	     iter = g_sequence_iter_next(iter))
-	{
-		DBusMenuItem *item = (DBusMenuItem *)g_sequence_get(iter);
-		if (item->section_num == position && item->place == -1)
-		{
-			*table = g_hash_table_ref(item->links);
-			return;
-		}
-	}
+	DBusMenuItem *item  = dbus_menu_model_find_section(menu, position);
+	if (item != NULL)
+		*table = g_hash_table_ref(item->links);
 }
 
 static int dbus_menu_model_is_mutable(GMenuModel *model)
@@ -124,9 +159,63 @@ struct layout_data
 	uint new_num;
 };
 
-GSequence *dbus_menu_model_items(DBusMenuModel *model)
+G_GNUC_INTERNAL uint dbus_menu_model_get_section_n_items(DBusMenuModel *model, uint section_num)
+{
+	if (section_num >= model->sections->len)
+		return 0;
+	GPtrArray *slots = (GPtrArray *)g_ptr_array_index(model->sections, section_num);
+	// Slot 0 is a section item itself
+	return slots->len > 0 ? slots->len - 1 : 0;
+}
+
+G_GNUC_INTERNAL DBusMenuItem *dbus_menu_model_get_section_item(DBusMenuModel *model,
+                                                               uint section_num, int place)
+{
+	return dbus_menu_model_find_item(model, section_num, place);
+}
+
+static GPtrArray *dbus_menu_model_section_slots(DBusMenuModel *menu, uint section_num)
+{
+	while (menu->sections->len <= section_num)
+		g_ptr_array_add(menu->sections, g_ptr_array_new());
+	return (GPtrArray *)g_ptr_array_index(menu->sections, section_num);
+}
+
+static void dbus_menu_model_section_set_slot(GPtrArray *slots, uint slot, DBusMenuItem *item)
+{
+	if (slots->len <= slot)
+		g_ptr_array_set_size(slots, slot + 1);
+	g_ptr_array_index(slots, slot) = item;
+}
+
+static GSequenceIter *dbus_menu_model_insert_item(DBusMenuModel *menu, DBusMenuItem *item)
 {
-	return model->items;
+	GPtrArray *slots = dbus_menu_model_section_slots(menu, item->section_num);
+	dbus_menu_model_section_set_slot(slots, item->place + 1, item);
+	g_hash_table_insert(menu->items_by_id, GUINT_TO_POINTER(item->id), item);
+	item->parent_model = menu;
+	return g_sequence_insert_sorted(menu->items, item, dbus_menu_model_sort_func, NULL);
+}
+
+// Called from dbus_menu_item_free, so index never points to freed items
+G_GNUC_INTERNAL void dbus_menu_model_unindex_item(DBusMenuModel *menu, DBusMenuItem *item)
+{
+	item->parent_model = NULL;
+	// Model is finalizing, index is already destroyed
+	if (menu->items_by_id == NULL)
+		return;
+	if (g_hash_table_lookup(menu->items_by_id, GUINT_TO_POINTER(item->id)) == item)
+		g_hash_table_remove(menu->items_by_id, GUINT_TO_POINTER(item->id));
+	if ((uint)item->section_num >= menu->sections->len)
+		return;
+	GPtrArray *slots = (GPtrArray *)g_ptr_array_index(menu->sections, item->section_num);
+	uint slot        = item->place + 1;
+	if (slot >= slots->len || g_ptr_array_index(slots, slot) != item)
+		return;
+	g_ptr_array_index(slots, slot) = NULL;
+	// Keep slots dense: only tail of section can be removed
+	while (slots->len > 0 && g_ptr_array_index(slots, slots->len - 1) == NULL)
+		g_ptr_array_remove_index(slots, slots->len - 1);
 }
 
 int queue_compare_func(const struct layout_data *a, const struct layout_data *b)
@@ -173,7 +262,9 @@ static void add_signal_to_queue(DBusMenuModel *model, GQueue *queue, int sect_nu
 	data->new_num     = added;
 	gpointer l        = g_queue_find_custom(queue, data, (GCompareFunc)queue_compare_func);
 	if (!l)
-		g_queue_push_head(queue, data);
+		g_queue_push_tail(queue, data);
+	else
+		g_free(data);
 }
 
 static bool queue_emit_now(struct layout_data *index)
@@ -192,10 +283,15 @@ static void queue_emit_all(GQueue *queue)
 		g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, G_SOURCE_FUNC(queue_emit_now), index, g_free);
 }
 
-static bool preload_idle(DBusMenuItem *item)
+// Signals are emitted in queue order, and each one should see model state after previous ones
+static void queue_emit_sync(GQueue *queue)
 {
-	dbus_menu_item_preload(item);
-	return G_SOURCE_REMOVE;
+	struct layout_data *index = NULL;
+	while ((index = (struct layout_data *)g_queue_pop_head(queue)))
+	{
+		queue_emit_now(index);
+		g_free(index);
+	}
 }
 
 static void menu_item_copy_and_load(DBusMenuModel *menu, DBusMenuItem *old, DBusMenuItem *new_item)
@@ -204,43 +300,66 @@ static void menu_item_copy_and_load(DBusMenuModel *menu, DBusMenuItem *old, DBus
 	dbus_menu_item_generate_action(new_item, menu);
 	// It is a preload hack. If this is a toplevel menu, we need to fetch menu under toplevel to
 	// avoid menu jumping bug. Now we need to use it for all menus - no menus are preloaded,
-	// AFAIK
+	// AFAIK. Preload itself is queued after item is placed in menu.
 	dbus_menu_item_update_enabled(new_item, true);
 	new_item->toggled = true;
-	g_timeout_add_full(100, 300, (GSourceFunc)preload_idle, new_item, NULL);
 }
 
-// We deal only with layouts with depth 1 (not all)
-static void layout_parse(DBusMenuModel *menu, GVariant *layout)
+struct layout_entry
 {
-	guint id;
+	DBusMenuItem *item;
 	GVariant *props;
-	GVariant *items;
-	if (!g_variant_is_of_type(layout, G_VARIANT_TYPE("(ia{sv}av)")))
-	{
-		g_warning(
-		    "Type of return value for 'layout' property in "
-		    "'GetLayout' call should be '(ia{sv}av)' but got '%s'",
-		    g_variant_get_type_string(layout));
+	// Prefetched children, NULL if they were not requested
+	GVariant *children;
+};
+
+static void layout_entry_clear(struct layout_entry *entry)
+{
+	// Item is NULL if it was moved to the model
+	g_clear_pointer(&entry->item, dbus_menu_item_free);
+	g_clear_pointer(&entry->props, g_variant_unref);
+	g_clear_pointer(&entry->children, g_variant_unref);
+}
 
+// Received children of a submenu are parsed directly into its model, so it does not need
+// its own GetLayout call. When budget runs out, remaining submenus are loaded on demand.
+static void layout_feed_submenu(DBusMenuItem *item, GVariant *children,
+                                struct layout_budget *budget)
+{
+	if (children == NULL || item->action_type != DBUS_MENU_ACTION_SUBMENU)
 		return;
-	}
-	//We really should not run if we are not a menu
-	if(!DBUS_MENU_IS_MODEL(menu))
+	DBusMenuModel *submenu = dbus_menu_item_get_submenu(item);
+	uint n_children        = g_variant_n_children(children);
+	if (submenu == NULL || n_children > budget->items_left)
+	{
+		budget->items_left = 0;
 		return;
-	g_variant_get(layout, "(i@a{sv}@av)", &id, &props, &items);
-	g_variant_unref(props);
+	}
+	budget->items_left -= n_children;
+	struct layout_budget nested = { budget->depth > 0 ? budget->depth - 1 : budget->depth,
+		                        budget->items_left };
+	layout_apply(submenu, children, &nested);
+	budget->items_left              = nested.items_left;
+	submenu->layout_update_required = false;
+}
+
+static GArray *layout_section_new(void)
+{
+	GArray *section = g_array_new(false, false, sizeof(struct layout_entry));
+	g_array_set_clear_func(section, (GDestroyNotify)layout_entry_clear);
+	return section;
+}
+
+// Split received items by sections. First section has no section item, so headers[0] is
+// always NULL.
+static void layout_split(DBusMenuModel *menu, GVariant *items, struct layout_budget *budget,
+                         GPtrArray *headers, GPtrArray *sections)
+{
 	GVariantIter iter;
 	GVariant *child;
-	// Start parsing. We need to track section number, and also GSequenceIter to
-	// current section. Also we track change position, number of added and removed
-	// items for current section
-	uint section_num            = 0;
-	uint place                  = 0;
-	uint old_sections           = g_menu_model_get_n_items(G_MENU_MODEL(menu));
-	uint added                  = 0;
-	int change_pos              = -1;
-	GSequenceIter *current_iter = g_sequence_get_begin_iter(menu->items);
+	GArray *current = layout_section_new();
+	g_ptr_array_add(headers, NULL);
+	g_ptr_array_add(sections, current);
 	g_variant_iter_init(&iter, items);
 	while ((child = g_variant_iter_next_value(&iter)))
 	{
@@ -249,146 +368,317 @@ static void layout_parse(DBusMenuModel *menu, GVariant *layout)
 		GVariant *cprops;
 		GVariant *citems;
 		g_variant_get(value, "(i@a{sv}@av)", &cid, &cprops, &citems);
-		g_variant_unref(citems);
+		// Empty children may mean that submenu is filled on AboutToShow only
+		if (budget->depth == 1 || g_variant_n_children(citems) == 0)
+			g_clear_pointer(&citems, g_variant_unref);
 
-		DBusMenuItem *old      = NULL;
 		DBusMenuItem *new_item = dbus_menu_item_new(cid, menu, cprops);
-		// We receive a section (separator or x-kde-title)
+		// We receive a section (separator or x-kde-title). It is valid only if it is visible
+		// and there are items before it.
 		if (new_item->action_type == DBUS_MENU_ACTION_SECTION)
 		{
-			bool is_valid_section = !new_item->toggled && place > 0;
-			// Section is valid, so, parse it
-			if (is_valid_section)
+			if (!new_item->toggled && current->len > 0)
 			{
-				// Do some common tasks: increment section_num and iter
-				++section_num;
-				place--;
-				new_item->section_num = section_num;
-				new_item->place       = -1;
-				GSequenceIter *old_iter =
-				    g_sequence_lookup(menu->items,
-				                      new_item,
-				                      dbus_menu_model_sort_func,
-				                      NULL);
-				if (!old_iter)
-				{
-					g_hash_table_insert(
-					    new_item->links,
-					    G_MENU_LINK_SECTION,
-					    dbus_menu_section_model_new(menu, section_num));
-					old_iter =
-					    g_sequence_insert_sorted(menu->items,
-					                             new_item,
-					                             dbus_menu_model_sort_func,
-					                             NULL);
-				}
-				else
-					dbus_menu_item_free(new_item);
-				old =
-				    (DBusMenuItem *)g_sequence_get(g_sequence_iter_prev(old_iter));
-				int delta                 = old->place - place;
-				GSequenceIter *place_iter = g_sequence_iter_move(old_iter, -delta);
-				// Cleanup all items in prev section (if there is more items than
-				// current)
-				if (delta > 0)
-					g_sequence_remove_range(place_iter, old_iter);
-				// Section signal will do it for us, do not send additional one
-				// Update current_section and reset current_iter and added to new
-				// section
-				current_iter = g_sequence_iter_next(old_iter);
-				added        = 0;
-				change_pos   = -1;
-				place        = 0;
+				current = layout_section_new();
+				g_ptr_array_add(headers, new_item);
+				g_ptr_array_add(sections, current);
 			}
-			// If section was invalid, just free received item.
 			else
 				dbus_menu_item_free(new_item);
+			g_variant_unref(cprops);
+			g_clear_pointer(&citems, g_variant_unref);
 		}
 		else if (!dbus_menu_item_is_firefox_stub(new_item))
 		{
-			new_item->section_num   = section_num;
-			new_item->place         = place;
-			GSequenceIter *old_iter = g_sequence_lookup(menu->items,
-			                                            new_item,
-			                                            dbus_menu_model_sort_func,
-			                                            NULL);
-			// There is no old item on this place
-			if (!old_iter)
-			{
-				if (!added)
-					change_pos = change_pos < 0 ? place : change_pos;
-				menu_item_copy_and_load(menu, NULL, new_item);
-				current_iter = g_sequence_insert_sorted(menu->items,
-				                                        new_item,
-				                                        dbus_menu_model_sort_func,
-				                                        NULL);
-				added++;
-			}
-			// If there is an old item exists, we need to check this properties
-			else
-			{
-				old = (DBusMenuItem *)g_sequence_get(old_iter);
-				// We should compare properties of old and new item
-				bool diff    = !dbus_menu_item_compare_immutable(old, new_item);
-				dbus_menu_item_update_props(old, cprops);
-				if (diff)
-				{
-					// Immutable properties was different, replace menu item
-					menu_item_copy_and_load(menu, old, new_item);
-					g_sequence_remove(old_iter);
-					current_iter =
-					    g_sequence_insert_sorted(menu->items,
-					                             new_item,
-					                             dbus_menu_model_sort_func,
-					                             NULL);
-				}
-				else
-				{
-					// Just free unneeded item
-					dbus_menu_item_free(new_item);
-				}
-			}
-			current_iter = g_sequence_iter_next(current_iter);
-			place++;
+			struct layout_entry entry = { new_item, cprops, citems };
+			g_array_append_val(current, entry);
 		}
 		else
+		{
 			// Just free unnedeed item
 			dbus_menu_item_free(new_item);
-		g_variant_unref(cprops);
+			g_variant_unref(cprops);
+			g_clear_pointer(&citems, g_variant_unref);
+		}
 		g_variant_unref(value);
 		g_variant_unref(child);
 	}
-	section_num++;
-	int secdiff = old_sections - section_num;
-	if (secdiff > 0)
+}
+
+static bool layout_item_is_same(DBusMenuItem *old, DBusMenuItem *received)
+{
+	return old->id == received->id && dbus_menu_item_compare_immutable(old, received);
+}
+
+#define layout_received_item(section, i) (g_array_index((section), struct layout_entry, (i)).item)
+
+// Match old items of the section to received ones by longest common subsequence of ids.
+// Returns index of matched old item (or -1) for every received item.
+static int *layout_section_match(DBusMenuItem **old_items, uint old_len, GArray *received)
+{
+	uint new_len = received->len;
+	int *matches = g_new(int, new_len + 1);
+	uint prefix = 0, suffix = 0;
+	for (uint j = 0; j < new_len; j++)
+		matches[j] = -1;
+	// Typical update changes few items, so cut common head and tail first
+	while (prefix < old_len && prefix < new_len &&
+	       layout_item_is_same(old_items[prefix], layout_received_item(received, prefix)))
+	{
+		matches[prefix] = prefix;
+		prefix++;
+	}
+	while (suffix < old_len - prefix && suffix < new_len - prefix &&
+	       layout_item_is_same(old_items[old_len - suffix - 1],
+	                           layout_received_item(received, new_len - suffix - 1)))
+	{
+		matches[new_len - suffix - 1] = old_len - suffix - 1;
+		suffix++;
+	}
+	uint a = old_len - prefix - suffix;
+	uint b = new_len - prefix - suffix;
+	// Replace the whole middle if table is too big
+	if (a == 0 || b == 0 || (gsize)(a + 1) * (b + 1) > LAYOUT_DIFF_MAX_CELLS)
+		return matches;
+	// lcs[i * (b + 1) + j] is a length of LCS of old[i..a) and received[j..b)
+	uint stride = b + 1;
+	guint *lcs  = g_new0(guint, (gsize)(a + 1) * stride);
+	for (int i = a - 1; i >= 0; i--)
+		for (int j = b - 1; j >= 0; j--)
+		{
+			if (layout_item_is_same(old_items[prefix + i],
+			                        layout_received_item(received, prefix + j)))
+				lcs[i * stride + j] = lcs[(i + 1) * stride + j + 1] + 1;
+			else
+				lcs[i * stride + j] =
+				    MAX(lcs[(i + 1) * stride + j], lcs[i * stride + j + 1]);
+		}
+	for (uint i = 0, j = 0; i < a && j < b;)
+	{
+		if (layout_item_is_same(old_items[prefix + i],
+		                        layout_received_item(received, prefix + j)))
+		{
+			matches[prefix + j] = prefix + i;
+			i++;
+			j++;
+		}
+		else if (lcs[(i + 1) * stride + j] >= lcs[i * stride + j + 1])
+			i++;
+		else
+			j++;
+	}
+	g_free(lcs);
+	return matches;
+}
+
+struct layout_hunk
+{
+	int pos;
+	uint removed;
+	uint added;
+};
+
+static void layout_hunk_flush(DBusMenuModel *menu, GQueue *signal_queue, uint section_num,
+                              struct layout_hunk *hunk)
+{
+	if (hunk->pos >= 0)
+		add_signal_to_queue(menu,
+		                    signal_queue,
+		                    section_num,
+		                    hunk->pos,
+		                    hunk->removed,
+		                    hunk->added);
+	hunk->pos = -1;
+}
+
+// Adjacent changes are merged, so each run of changed items gives one signal
+static void layout_hunk_add(DBusMenuModel *menu, GQueue *signal_queue, uint section_num,
+                            struct layout_hunk *hunk, uint pos, uint removed, uint added)
+{
+	if (removed == 0 && added == 0)
+		return;
+	if (hunk->pos >= 0 && pos == hunk->pos + hunk->added)
+	{
+		hunk->removed += removed;
+		hunk->added += added;
+		return;
+	}
+	layout_hunk_flush(menu, signal_queue, section_num, hunk);
+	hunk->pos     = pos;
+	hunk->removed = removed;
+	hunk->added   = added;
+}
+
+static void layout_section_apply(DBusMenuModel *menu, uint section_num, GArray *received,
+                                 struct layout_budget *budget, GQueue *signal_queue)
+{
+	uint old_len = dbus_menu_model_get_section_n_items(menu, section_num);
+	uint new_len = received->len;
+	g_autofree DBusMenuItem **old_items = g_new0(DBusMenuItem *, old_len + 1);
+	g_autofree bool *kept               = g_new0(bool, old_len + 1);
+	g_autofree bool *changed            = g_new0(bool, new_len + 1);
+	for (uint i = 0; i < old_len; i++)
+		old_items[i] = dbus_menu_model_find_item(menu, section_num, i);
+	g_autofree int *matches = layout_section_match(old_items, old_len, received);
+	for (uint j = 0; j < new_len; j++)
+		if (matches[j] >= 0)
+			kept[matches[j]] = true;
+	// Remove items which are not in the layout anymore. Order of remaining ones is kept.
+	for (uint i = 0; i < old_len; i++)
+		if (!kept[i])
+			g_sequence_remove(dbus_menu_model_find_place(menu, section_num, i));
+	// Move remaining items to new places. Mapping is monotonic, so sequence stays sorted, and
+	// places for inserted items are free after it.
+	GPtrArray *slots = dbus_menu_model_section_slots(menu, section_num);
+	g_ptr_array_set_size(slots, 1);
+	for (uint j = 0; j < new_len; j++)
+	{
+		if (matches[j] < 0)
+			continue;
+		struct layout_entry *entry = &g_array_index(received, struct layout_entry, j);
+		DBusMenuItem *old          = old_items[matches[j]];
+		old->place                 = j;
+		dbus_menu_model_section_set_slot(slots, j + 1, old);
+		changed[j] = dbus_menu_item_update_props(old, entry->props);
+		layout_feed_submenu(old, entry->children, budget);
+	}
+	for (uint j = 0; j < new_len; j++)
+	{
+		if (matches[j] >= 0)
+			continue;
+		struct layout_entry *entry = &g_array_index(received, struct layout_entry, j);
+		entry->item->section_num   = section_num;
+		entry->item->place         = j;
+		menu_item_copy_and_load(menu, NULL, entry->item);
+		dbus_menu_model_insert_item(menu, entry->item);
+		dbus_menu_item_preload(entry->item);
+		layout_feed_submenu(entry->item, entry->children, budget);
+		entry->item = NULL;
+	}
+	// Walk matched pairs, and signal about everything between them. Positions are in new
+	// layout, because previous changes are already applied when signal is handled.
+	struct layout_hunk hunk = { -1, 0, 0 };
+	uint old_next = 0, new_next = 0;
+	for (uint j = 0; j <= new_len; j++)
+	{
+		if (j < new_len && matches[j] < 0)
+			continue;
+		uint old_pos = j < new_len ? (uint)matches[j] : old_len;
+		layout_hunk_add(menu,
+		                signal_queue,
+		                section_num,
+		                &hunk,
+		                new_next,
+		                old_pos - old_next,
+		                j - new_next);
+		if (j < new_len && changed[j])
+			layout_hunk_add(menu, signal_queue, section_num, &hunk, j, 1, 1);
+		old_next = old_pos + 1;
+		new_next = j + 1;
+	}
+	layout_hunk_flush(menu, signal_queue, section_num, &hunk);
+}
+
+static void layout_section_append(DBusMenuModel *menu, uint section_num, DBusMenuItem *header,
+                                  GArray *received, struct layout_budget *budget)
+{
+	header->section_num = section_num;
+	header->place       = -1;
+	g_hash_table_insert(header->links,
+	                    G_MENU_LINK_SECTION,
+	                    dbus_menu_section_model_new(menu, section_num));
+	dbus_menu_model_insert_item(menu, header);
+	for (uint j = 0; j < received->len; j++)
 	{
-		GSequenceIter *section_iter = dbus_menu_model_find_place(menu, section_num, -1);
+		struct layout_entry *entry = &g_array_index(received, struct layout_entry, j);
+		entry->item->section_num   = section_num;
+		entry->item->place         = j;
+		menu_item_copy_and_load(menu, NULL, entry->item);
+		dbus_menu_model_insert_item(menu, entry->item);
+		dbus_menu_item_preload(entry->item);
+		layout_feed_submenu(entry->item, entry->children, budget);
+		entry->item = NULL;
+	}
+}
+
+// Items are applied to this menu, and their children (if layout is deeper than 1) go to
+// submenus while budget allows
+static void layout_apply(DBusMenuModel *menu, GVariant *items, struct layout_budget *budget)
+{
+	g_autoptr(GPtrArray) headers = g_ptr_array_new_with_free_func(dbus_menu_item_free);
+	g_autoptr(GPtrArray) sections =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_array_unref);
+	g_autoptr(GQueue) signal_queue = g_queue_new();
+	layout_split(menu, items, budget, headers, sections);
+	// Sections are compared by position, and items inside them are compared by id. So
+	// only changed parts of changed sections are signalled.
+	uint old_sections = menu->sections->len;
+	uint new_sections = sections->len;
+	uint common       = MIN(old_sections, new_sections);
+	if (old_sections > new_sections)
+	{
+		GSequenceIter *section_iter = dbus_menu_model_find_place(menu, new_sections, -1);
 		g_sequence_remove_range(section_iter, g_sequence_get_end_iter(menu->items));
+		// Removed sections have no items left in index
+		g_ptr_array_remove_range(menu->sections, new_sections, old_sections - new_sections);
+	}
+	for (uint i = 0; i < common; i++)
+		layout_section_apply(menu,
+		                     i,
+		                     g_ptr_array_index(sections, i),
+		                     budget,
+		                     signal_queue);
+	for (uint i = common; i < new_sections; i++)
+	{
+		DBusMenuItem *header          = g_ptr_array_index(headers, i);
+		g_ptr_array_index(headers, i) = NULL;
+		layout_section_append(menu, i, header, g_ptr_array_index(sections, i), budget);
 	}
-	// We need to manage last section's changes. And check its validity
-	if (secdiff >= 0)
+	if (old_sections != new_sections)
+		add_signal_to_queue(menu,
+		                    signal_queue,
+		                    -1,
+		                    common,
+		                    old_sections - common,
+		                    new_sections - common);
+	queue_emit_sync(signal_queue);
+}
+
+static void layout_parse(DBusMenuModel *menu, GVariant *layout, int depth)
+{
+	guint id;
+	GVariant *props;
+	g_autoptr(GVariant) items = NULL;
+	if (!g_variant_is_of_type(layout, G_VARIANT_TYPE("(ia{sv}av)")))
+	{
+		g_warning(
+		    "Type of return value for 'layout' property in "
+		    "'GetLayout' call should be '(ia{sv}av)' but got '%s'",
+		    g_variant_get_type_string(layout));
+
+		return;
+	}
+	//We really should not run if we are not a menu
+	if(!DBUS_MENU_IS_MODEL(menu))
+		return;
+	// Too big tree is not kept at all, its submenus will be loaded on demand
+	if (depth != 1 && g_variant_get_size(layout) > menu->prefetch_max_bytes)
 	{
-		place--;
-		DBusMenuItem *old = (DBusMenuItem *)g_sequence_get(
-		    g_sequence_iter_prev(g_sequence_get_end_iter(menu->items)));
-		int delta                 = old->place - place;
-		GSequenceIter *last_iter  = g_sequence_get_end_iter(menu->items);
-		GSequenceIter *place_iter = g_sequence_iter_move(last_iter, -delta);
-
-		// Cleanup all items in prev section (if there is more items than
-		// current)
-		if (delta > 0)
-			g_sequence_remove_range(place_iter, last_iter);
+		g_debug("Layout of %u is too big for prefetch, disabling it", menu->parent_id);
+		menu->prefetch_depth = 1;
+		depth                = 1;
 	}
-	g_variant_unref(items);
-	// Update all layout
-	g_menu_model_items_changed(G_MENU_MODEL(menu), 0, old_sections, section_num);
+	g_variant_get(layout, "(i@a{sv}@av)", &id, &props, &items);
+	g_variant_unref(props);
+	struct layout_budget budget = { depth, menu->prefetch_max_items };
+	layout_apply(menu, items, &budget);
+	g_signal_emit(menu, signals[LAYOUT_APPLIED_SIGNAL], 0);
 }
 
 static bool get_layout_idle(DBusMenuModel *self)
 {
 	g_return_val_if_fail(DBUS_MENU_IS_MODEL(self), G_SOURCE_REMOVE);
-	layout_parse(self, self->current_layout);
+	layout_parse(self, self->current_layout, self->requested_depth);
 	self->parse_pending = 0;
 	return G_SOURCE_REMOVE;
 }
@@ -413,8 +703,13 @@ static void get_layout_cb(GObject *source_object, GAsyncResult *res, gpointer us
 		g_object_unref(menu);
 		return;
 	}
+	g_signal_emit(menu, signals[LAYOUT_RECEIVED_SIGNAL], 0);
+	// First layout is shown at once, only later updates are coalesced
+	bool first_load              = menu->layout_update_required;
 	menu->layout_update_required = false;
-	if (!menu->parse_pending)
+	if (first_load && !menu->parse_pending)
+		layout_parse(menu, menu->current_layout, menu->requested_depth);
+	else if (!menu->parse_pending)
 		menu->parse_pending = g_timeout_add_full(G_PRIORITY_HIGH,
 		                                         100,
 		                                         (GSourceFunc)get_layout_idle,
@@ -423,9 +718,57 @@ static void get_layout_cb(GObject *source_object, GAsyncResult *res, gpointer us
 	g_object_unref(menu);
 }
 
-static void dbus_menu_update_item_properties_from_layout_sync(DBusMenuModel *menu,
-                                                              DBusMenuItem *item, int sect_n,
-                                                              int pos)
+static void get_group_properties_cb(GObject *source_object, GAsyncResult *res,
+                                    gpointer user_data)
+{
+	DBusMenuModel *menu       = DBUS_MENU_MODEL(user_data);
+	g_autoptr(GVariant) props = NULL;
+	g_autoptr(GError) error   = NULL;
+	dbus_menu_xml_call_get_group_properties_finish((DBusMenuXml *)(source_object),
+	                                               &props,
+	                                               res,
+	                                               &error);
+	if (error != NULL)
+	{
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_warning("%s", error->message);
+		g_object_unref(menu);
+		return;
+	}
+	// Layout will be parsed anyway, so it will get these properties
+	if (!menu->parse_pending)
+	{
+		g_autoptr(GQueue) signal_queue = g_queue_new();
+		items_properties_loop(menu, props, signal_queue, false);
+		queue_emit_all(signal_queue);
+	}
+	g_object_unref(menu);
+}
+
+static bool get_group_properties_idle(DBusMenuModel *menu)
+{
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	gpointer id;
+	menu->props_pending = 0;
+	if (!DBUS_MENU_IS_XML(menu->xml) || g_hash_table_size(menu->pending_props) == 0)
+		return G_SOURCE_REMOVE;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("ai"));
+	g_hash_table_iter_init(&iter, menu->pending_props);
+	while (g_hash_table_iter_next(&iter, &id, NULL))
+		g_variant_builder_add(&builder, "i", GPOINTER_TO_UINT(id));
+	g_hash_table_remove_all(menu->pending_props);
+	dbus_menu_xml_call_get_group_properties(menu->xml,
+	                                        g_variant_builder_end(&builder),
+	                                        property_names,
+	                                        menu->cancellable,
+	                                        get_group_properties_cb,
+	                                        g_object_ref(menu));
+	return G_SOURCE_REMOVE;
+}
+
+// All requests made during one main loop iteration are sent as one GetGroupProperties call
+static void dbus_menu_model_queue_item_properties(DBusMenuModel *menu, DBusMenuItem *item)
 {
 	g_return_if_fail(DBUS_MENU_IS_MODEL(menu));
 
@@ -434,45 +777,129 @@ static void dbus_menu_update_item_properties_from_layout_sync(DBusMenuModel *men
 		dbus_menu_model_update_layout(menu);
 		return;
 	}
-	g_autoptr(GVariant) props      = NULL;
-	g_autoptr(GVariant) items      = NULL;
-	g_autoptr(GVariant) layout     = NULL;
-	g_autoptr(GError) error        = NULL;
-	g_autoptr(GQueue) signal_queue = g_queue_new();
-	guint id, revision;
-	dbus_menu_xml_call_get_layout_sync(menu->xml,
-	                                   item->id,
-	                                   0,
-	                                   property_names,
-	                                   &revision,
-	                                   &layout,
-	                                   menu->cancellable,
-	                                   &error);
-	if (error != NULL)
-	{
-		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-			g_warning("%s", error->message);
-		return;
-	}
-	g_variant_get(layout, "(i@a{sv}@av)", &id, &props, &items);
-	bool is_item_updated = dbus_menu_item_update_props(item, props);
-	if (is_item_updated)
-		add_signal_to_queue(menu, signal_queue, sect_n, pos, 1, 1);
-	queue_emit_all(signal_queue);
+	g_hash_table_add(menu->pending_props, GUINT_TO_POINTER(item->id));
+	if (!menu->props_pending)
+		menu->props_pending = g_idle_add_full(G_PRIORITY_DEFAULT,
+		                                      (GSourceFunc)get_group_properties_idle,
+		                                      g_object_ref(menu),
+		                                      g_object_unref);
 }
 
+// Deeper layout is requested only for first load, later updates are local to a menu
 G_GNUC_INTERNAL void dbus_menu_model_update_layout(DBusMenuModel *menu)
 {
 	g_return_if_fail(DBUS_MENU_IS_MODEL(menu));
+	menu->requested_depth = menu->layout_update_required ? menu->prefetch_depth : 1;
 	dbus_menu_xml_call_get_layout(menu->xml,
 	                              menu->parent_id,
-	                              1,
+	                              menu->requested_depth,
 	                              property_names,
 	                              menu->cancellable,
 	                              get_layout_cb,
 	                              g_object_ref(menu));
 }
 
+static void get_layout_group_cb(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GPtrArray) models = (GPtrArray *)user_data;
+	g_autoptr(GVariant) layout  = NULL;
+	g_autoptr(GVariant) items   = NULL;
+	g_autoptr(GError) error     = NULL;
+	guint revision;
+	dbus_menu_xml_call_get_layout_finish(DBUS_MENU_XML(source_object),
+	                                     &revision,
+	                                     &layout,
+	                                     res,
+	                                     &error);
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+	if (error != NULL)
+		g_debug("GetLayout of submenus failed: %s", error->message);
+	else if (g_variant_is_of_type(layout, G_VARIANT_TYPE("(ia{sv}av)")))
+	{
+		GVariantIter iter;
+		GVariant *child;
+		g_variant_get(layout, "(i@a{sv}@av)", NULL, NULL, &items);
+		g_variant_iter_init(&iter, items);
+		while ((child = g_variant_iter_next_value(&iter)))
+		{
+			g_autoptr(GVariant) value  = g_variant_get_variant(child);
+			g_autoptr(GVariant) citems = NULL;
+			int cid;
+			g_variant_get(value, "(i@a{sv}@av)", &cid, NULL, &citems);
+			for (uint i = 0; i < models->len; i++)
+			{
+				DBusMenuModel *menu = DBUS_MENU_MODEL(g_ptr_array_index(models, i));
+				if (menu->parent_id != (uint)cid || menu->parse_pending)
+					continue;
+				struct layout_budget budget = { 1, menu->prefetch_max_items };
+				layout_apply(menu, citems, &budget);
+				menu->layout_update_required = false;
+				g_ptr_array_remove_index_fast(models, i);
+				break;
+			}
+			g_variant_unref(child);
+		}
+	}
+	// Submenus which are missing from the parent layout are loaded one by one
+	for (uint i = 0; i < models->len; i++)
+	{
+		DBusMenuModel *menu = DBUS_MENU_MODEL(g_ptr_array_index(models, i));
+		if (DBUS_MENU_IS_XML(menu->xml))
+			dbus_menu_model_update_layout(menu);
+	}
+}
+
+// Sibling submenus which need a layout are loaded with one GetLayout of their parent menu,
+// limited to depth 2, and its reply is split into them
+G_GNUC_INTERNAL void dbus_menu_model_update_layouts(GPtrArray *models, GCancellable *cancellable)
+{
+	g_autoptr(GHashTable) by_owner = g_hash_table_new_full(g_direct_hash,
+	                                                       g_direct_equal,
+	                                                       NULL,
+	                                                       (GDestroyNotify)g_ptr_array_unref);
+	GHashTableIter iter;
+	gpointer owner_id;
+	gpointer value;
+	for (uint i = 0; i < models->len; i++)
+	{
+		DBusMenuModel *menu = DBUS_MENU_MODEL(g_ptr_array_index(models, i));
+		if (!DBUS_MENU_IS_XML(menu->xml))
+			continue;
+		if (menu->owner_id == UINT_MAX || menu->parse_pending)
+		{
+			dbus_menu_model_update_layout(menu);
+			continue;
+		}
+		GPtrArray *siblings =
+		    (GPtrArray *)g_hash_table_lookup(by_owner, GUINT_TO_POINTER(menu->owner_id));
+		if (siblings == NULL)
+		{
+			siblings = g_ptr_array_new_with_free_func(g_object_unref);
+			g_hash_table_insert(by_owner, GUINT_TO_POINTER(menu->owner_id), siblings);
+		}
+		g_ptr_array_add(siblings, g_object_ref(menu));
+	}
+	g_hash_table_iter_init(&iter, by_owner);
+	while (g_hash_table_iter_next(&iter, &owner_id, &value))
+	{
+		GPtrArray *siblings  = (GPtrArray *)value;
+		DBusMenuModel *first = DBUS_MENU_MODEL(g_ptr_array_index(siblings, 0));
+		if (siblings->len == 1)
+		{
+			dbus_menu_model_update_layout(first);
+			continue;
+		}
+		dbus_menu_xml_call_get_layout(first->xml,
+		                              GPOINTER_TO_UINT(owner_id),
+		                              2,
+		                              property_names,
+		                              cancellable,
+		                              get_layout_group_cb,
+		                              g_ptr_array_ref(siblings));
+	}
+}
+
 static void layout_updated_cb(DBusMenuXml *proxy, guint revision, gint parent, DBusMenuModel *menu)
 {
 	if (!DBUS_MENU_IS_XML(proxy))
@@ -486,10 +913,7 @@ static void layout_updated_cb(DBusMenuXml *proxy, guint revision, gint parent, D
 	}
 	DBusMenuItem *item = dbus_menu_model_find(menu, (uint)parent);
 	if (item != NULL)
-		dbus_menu_update_item_properties_from_layout_sync(menu,
-		                                                  item,
-		                                                  item->section_num,
-		                                                  item->place);
+		dbus_menu_model_queue_item_properties(menu, item);
 }
 
 static void item_activation_requested_cb(DBusMenuXml *proxy, gint id, guint timestamp,
@@ -568,6 +992,27 @@ static void on_xml_property_changed(DBusMenuModel *model)
 		dbus_menu_model_update_layout(model);
 }
 
+// Menu without xml is emptied and its pending calls are dropped, next xml loads it anew
+static void dbus_menu_model_clear(DBusMenuModel *menu)
+{
+	g_autoptr(GVariant) items =
+	    g_variant_ref_sink(g_variant_new_array(G_VARIANT_TYPE_VARIANT, NULL, 0));
+	struct layout_budget budget = { 1, menu->prefetch_max_items };
+	g_cancellable_cancel(menu->cancellable);
+	g_clear_object(&menu->cancellable);
+	menu->cancellable = g_cancellable_new();
+	if (menu->parse_pending)
+		g_source_remove(menu->parse_pending);
+	menu->parse_pending = 0;
+	if (menu->props_pending)
+		g_source_remove(menu->props_pending);
+	menu->props_pending = 0;
+	g_hash_table_remove_all(menu->pending_props);
+	g_clear_pointer(&menu->current_layout, g_variant_unref);
+	menu->layout_update_required = true;
+	layout_apply(menu, items, &budget);
+}
+
 G_GNUC_INTERNAL DBusMenuModel *dbus_menu_model_new(uint parent_id, DBusMenuModel *parent,
                                                    DBusMenuXml *xml, GActionGroup *action_group)
 {
@@ -580,7 +1025,10 @@ G_GNUC_INTERNAL DBusMenuModel *dbus_menu_model_new(uint parent_id, DBusMenuModel
 	                                                   action_group,
 	                                                   NULL);
 	if (parent != NULL)
+	{
+		ret->owner_id = parent->parent_id;
 		g_object_bind_property(parent, "xml", ret, "xml", G_BINDING_SYNC_CREATE);
+	}
 	return ret;
 }
 
@@ -601,6 +1049,12 @@ static void dbus_menu_model_set_property(GObject *object, guint property_id, con
 			on_xml_property_changed(menu);
 			g_clear_object(&old_xml);
 		}
+		else if (menu->xml == NULL && old_xml != NULL)
+		{
+			g_signal_handlers_disconnect_by_data(old_xml, menu);
+			g_clear_object(&old_xml);
+			dbus_menu_model_clear(menu);
+		}
 		break;
 	case PROP_ACTION_GROUP:
 		g_clear_object(&menu->received_action_group);
@@ -645,45 +1099,66 @@ G_GNUC_INTERNAL bool dbus_menu_model_is_layout_update_required(DBusMenuModel *mo
 	return model->layout_update_required;
 }
 
+G_GNUC_INTERNAL GCancellable *dbus_menu_model_get_cancellable(DBusMenuModel *model)
+{
+	return model->cancellable;
+}
+
+G_GNUC_INTERNAL void dbus_menu_model_set_prefetch(DBusMenuModel *model, int depth, uint max_items,
+                                                  uint max_bytes)
+{
+	g_return_if_fail(DBUS_MENU_IS_MODEL(model));
+	model->prefetch_depth     = depth == 0 ? 1 : depth;
+	model->prefetch_max_items = max_items;
+	model->prefetch_max_bytes = max_bytes;
+}
+
 static DBusMenuItem *dbus_menu_model_find(DBusMenuModel *menu, uint item_id)
 {
-	for (GSequenceIter *iter = g_sequence_get_begin_iter(menu->items);
-	     !g_sequence_iter_is_end(iter);
-	     iter = g_sequence_iter_next(iter))
-	{
-		DBusMenuItem *item = (DBusMenuItem *)g_sequence_get(iter);
-		if (item->id == item_id)
-			return item;
-	}
-	return NULL;
+	return (DBusMenuItem *)g_hash_table_lookup(menu->items_by_id, GUINT_TO_POINTER(item_id));
+}
+
+static DBusMenuItem *dbus_menu_model_find_item(DBusMenuModel *menu, uint section_num, int place)
+{
+	if (section_num >= menu->sections->len || place < -1)
+		return NULL;
+	GPtrArray *slots = (GPtrArray *)g_ptr_array_index(menu->sections, section_num);
+	uint slot        = place + 1;
+	if (slot >= slots->len)
+		return NULL;
+	return (DBusMenuItem *)g_ptr_array_index(slots, slot);
 }
 
 static GSequenceIter *dbus_menu_model_find_place(DBusMenuModel *menu, uint section_num, int place)
 {
-	for (GSequenceIter *iter = g_sequence_get_begin_iter(menu->items);
-	     !g_sequence_iter_is_end(iter);
-	     iter = g_sequence_iter_next(iter))
-	{
-		DBusMenuItem *item = (DBusMenuItem *)g_sequence_get(iter);
-		if (item->section_num == section_num && item->place == place)
-			return iter;
-	}
-	return NULL;
+	DBusMenuItem *item = dbus_menu_model_find_item(menu, section_num, place);
+	if (item == NULL)
+		return NULL;
+	return g_sequence_lookup(menu->items, item, dbus_menu_model_sort_func, NULL);
 }
 
 static DBusMenuItem *dbus_menu_model_find_section(DBusMenuModel *menu, uint section_num)
 {
-	return (DBusMenuItem *)g_sequence_get(dbus_menu_model_find_place(menu, section_num, -1));
+	return dbus_menu_model_find_item(menu, section_num, -1);
 }
 
 static void dbus_menu_model_init(DBusMenuModel *menu)
 {
 	menu->cancellable            = g_cancellable_new();
 	menu->parent_id              = UINT_MAX;
+	menu->owner_id               = UINT_MAX;
 	menu->items                  = g_sequence_new(dbus_menu_item_free);
+	menu->items_by_id            = g_hash_table_new(g_direct_hash, g_direct_equal);
+	menu->sections = g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
 	menu->layout_update_required = true;
 	menu->parse_pending          = 0;
+	menu->prefetch_depth         = 1;
+	menu->prefetch_max_items     = DBUS_MENU_PREFETCH_MAX_ITEMS;
+	menu->prefetch_max_bytes     = DBUS_MENU_PREFETCH_MAX_BYTES;
+	menu->requested_depth        = 1;
 	menu->current_revision       = 0;
+	menu->pending_props          = g_hash_table_new(g_direct_hash, g_direct_equal);
+	menu->props_pending          = 0;
 }
 
 static void dbus_menu_model_constructed(GObject *object)
@@ -698,7 +1173,7 @@ static void dbus_menu_model_constructed(GObject *object)
 	g_hash_table_insert(first_section->links,
 	                    G_MENU_LINK_SECTION,
 	                    dbus_menu_section_model_new(menu, 0));
-	g_sequence_insert_sorted(menu->items, first_section, dbus_menu_model_sort_func, NULL);
+	dbus_menu_model_insert_item(menu, first_section);
 }
 
 static void dbus_menu_model_finalize(GObject *object)
@@ -712,8 +1187,12 @@ static void dbus_menu_model_finalize(GObject *object)
 	g_cancellable_cancel(menu->cancellable);
 	g_clear_object(&menu->cancellable);
 	g_clear_object(&menu->received_action_group);
+	// Items check index on free, so destroy it first
+	g_clear_pointer(&menu->items_by_id, g_hash_table_destroy);
 	g_clear_pointer(&menu->items, g_sequence_free);
+	g_clear_pointer(&menu->sections, g_ptr_array_unref);
 	g_clear_pointer(&menu->current_layout, g_variant_unref);
+	g_clear_pointer(&menu->pending_props, g_hash_table_destroy);
 
 	G_OBJECT_CLASS(dbus_menu_model_parent_class)->finalize(object);
 }
@@ -758,9 +1237,30 @@ static void dbus_menu_model_class_init(DBusMenuModelClass *klass)
 	object_class->get_property = dbus_menu_model_get_property;
 	object_class->constructed  = dbus_menu_model_constructed;
 
-	model_class->is_mutable          = dbus_menu_model_is_mutable;
-	model_class->get_n_items         = dbus_menu_model_get_n_items;
-	model_class->get_item_attributes = dbus_menu_model_get_item_attributes;
-	model_class->get_item_links      = dbus_menu_model_get_item_links;
+	model_class->is_mutable               = dbus_menu_model_is_mutable;
+	model_class->get_n_items              = dbus_menu_model_get_n_items;
+	model_class->get_item_attributes      = dbus_menu_model_get_item_attributes;
+	model_class->get_item_attribute_value = dbus_menu_model_get_item_attribute_value;
+	model_class->get_item_links           = dbus_menu_model_get_item_links;
 	install_properties(object_class);
+
+	// Reply to GetLayout of this model is received, and later its layout is applied
+	signals[LAYOUT_RECEIVED_SIGNAL] = g_signal_new(g_intern_static_string("layout-received"),
+	                                               dbus_menu_model_get_type(),
+	                                               G_SIGNAL_RUN_LAST,
+	                                               0,
+	                                               NULL,
+	                                               NULL,
+	                                               g_cclosure_marshal_VOID__VOID,
+	                                               G_TYPE_NONE,
+	                                               0);
+	signals[LAYOUT_APPLIED_SIGNAL]  = g_signal_new(g_intern_static_string("layout-applied"),
+	                                              dbus_menu_model_get_type(),
+	                                              G_SIGNAL_RUN_LAST,
+	                                              0,
+	                                              NULL,
+	                                              NULL,
+	                                              g_cclosure_marshal_VOID__VOID,
+	                                              G_TYPE_NONE,
+	                                              0);
 }
@@ -26,12 +26,21 @@
 G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE(DBusMenuModel, dbus_menu_model, DBUS_MENU, MODEL, GMenuModel)
+typedef struct _DBusMenuItem DBusMenuItem;
+
 G_GNUC_INTERNAL DBusMenuModel *dbus_menu_model_new(uint parent_id, DBusMenuModel *parent,
                                                    DBusMenuXml *xml, GActionGroup *action_group);
 G_GNUC_INTERNAL void dbus_menu_model_update_layout(DBusMenuModel *menu);
+G_GNUC_INTERNAL void dbus_menu_model_update_layouts(GPtrArray *models, GCancellable *cancellable);
 G_GNUC_INTERNAL bool dbus_menu_model_is_layout_update_required(DBusMenuModel *model);
+G_GNUC_INTERNAL GCancellable *dbus_menu_model_get_cancellable(DBusMenuModel *model);
+G_GNUC_INTERNAL void dbus_menu_model_set_prefetch(DBusMenuModel *model, int depth, uint max_items,
+                                                  uint max_bytes);
 
-G_GNUC_INTERNAL GSequence *dbus_menu_model_items(DBusMenuModel *model);
+G_GNUC_INTERNAL uint dbus_menu_model_get_section_n_items(DBusMenuModel *model, uint section_num);
+G_GNUC_INTERNAL DBusMenuItem *dbus_menu_model_get_section_item(DBusMenuModel *model,
+                                                               uint section_num, int place);
+G_GNUC_INTERNAL void dbus_menu_model_unindex_item(DBusMenuModel *model, DBusMenuItem *item);
 
 G_END_DECLS
 
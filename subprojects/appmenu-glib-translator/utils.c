@@ -21,21 +21,449 @@
 #include <utils.h>
 
 #include "definitions.h"
+#include "item.h"
 #include "model.h"
 
+// Events and AboutToShow calls are never sent synchronously. They are queued per client and
+// flushed once per main loop iteration, as one EventGroup and one AboutToShowGroup call when
+// client supports it. Order of calls on the bus is preserved, so "opened" always goes before
+// AboutToShow for the same menu.
+// Submenus which are preloaded go to separate prefetch queue, which is drained in slices with
+// lower priority, so user actions are not delayed by them. Submenus of menubar go first, then
+// submenus of a menu which user opened last.
+typedef struct
+{
+	uint id;
+	const char *event;
+} DBusMenuEvent;
+
+enum
+{
+	PREFETCH_TOPLEVEL,
+	PREFETCH_NEAR_POINTER,
+	PREFETCH_OTHER
+};
+
+typedef struct
+{
+	// Unowned, item cancels its entry when it is freed
+	DBusMenuItem *item;
+	DBusMenuModel *submenu;
+	int priority;
+	uint serial;
+} DBusMenuPrefetch;
+
+typedef struct
+{
+	DBusMenuXml *xml;
+	// Owner's cancellable, group replies are dropped once the owner is gone
+	GCancellable *cancellable;
+	GArray *events;
+	GPtrArray *shown;
+	GSequence *prefetch;
+	uint prefetch_serial;
+	// Unowned, used only for comparison
+	DBusMenuModel *pointer_model;
+	uint flush_source;
+	uint prefetch_source;
+	bool group_unsupported;
+} DBusMenuEventQueue;
+
+static void prefetch_free(DBusMenuPrefetch *entry)
+{
+	entry->item->prefetch = NULL;
+	g_object_unref(entry->submenu);
+	g_slice_free(DBusMenuPrefetch, entry);
+}
+
+static int prefetch_compare(const DBusMenuPrefetch *a, const DBusMenuPrefetch *b,
+                            G_GNUC_UNUSED gpointer user_data)
+{
+	if (a->priority != b->priority)
+		return a->priority < b->priority ? -1 : 1;
+	if (a->serial != b->serial)
+		return a->serial < b->serial ? -1 : 1;
+	return 0;
+}
+
+static void event_queue_free(DBusMenuEventQueue *queue)
+{
+	if (queue->flush_source > 0)
+		g_source_remove(queue->flush_source);
+	if (queue->prefetch_source > 0)
+		g_source_remove(queue->prefetch_source);
+	g_clear_pointer(&queue->events, g_array_unref);
+	g_clear_pointer(&queue->shown, g_ptr_array_unref);
+	g_clear_pointer(&queue->prefetch, g_sequence_free);
+	g_clear_object(&queue->cancellable);
+	g_slice_free(DBusMenuEventQueue, queue);
+}
+
+static DBusMenuEventQueue *event_queue_get(DBusMenuXml *xml)
+{
+	DBusMenuEventQueue *queue =
+	    (DBusMenuEventQueue *)g_object_get_data(G_OBJECT(xml), EVENT_QUEUE_QUARK_STR);
+	if (queue != NULL)
+		return queue;
+	queue           = g_slice_new0(DBusMenuEventQueue);
+	queue->xml      = xml;
+	queue->events   = g_array_new(false, false, sizeof(DBusMenuEvent));
+	queue->shown    = g_ptr_array_new_with_free_func(g_object_unref);
+	queue->prefetch = g_sequence_new((GDestroyNotify)prefetch_free);
+	// Queue is owned by proxy, so it is destroyed with it
+	g_object_set_data_full(G_OBJECT(xml),
+	                       EVENT_QUEUE_QUARK_STR,
+	                       queue,
+	                       (GDestroyNotify)event_queue_free);
+	return queue;
+}
+
+static void event_send_single(DBusMenuXml *xml, uint id, const char *event)
+{
+	// Event has no reply, so there is nothing to wait for
+	dbus_menu_xml_call_event(xml,
+	                         id,
+	                         event,
+	                         g_variant_new("v", g_variant_new_int32(0)),
+	                         CURRENT_TIME,
+	                         NULL,
+	                         NULL,
+	                         NULL);
+}
+
+static void event_group_cb(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GVariant) events    = (GVariant *)user_data;
+	g_autoptr(GVariant) id_errors = NULL;
+	g_autoptr(GError) error       = NULL;
+	DBusMenuXml *xml              = DBUS_MENU_XML(source_object);
+	dbus_menu_xml_call_event_group_finish(xml, &id_errors, res, &error);
+	if (error == NULL || g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+	g_debug("EventGroup failed: %s", error->message);
+	// Events may be already delivered on other errors, so they are resent only when
+	// client does not support groups, and groups are not tried again
+	if (!g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+		return;
+	event_queue_get(xml)->group_unsupported = true;
+	GVariantIter iter;
+	int id;
+	const char *event;
+	g_variant_iter_init(&iter, events);
+	while (g_variant_iter_loop(&iter, "(i&svu)", &id, &event, NULL, NULL))
+		event_send_single(xml, id, event);
+}
+
+static void event_queue_send_events(DBusMenuEventQueue *queue)
+{
+	if (queue->events->len == 1 || queue->group_unsupported)
+	{
+		for (uint i = 0; i < queue->events->len; i++)
+		{
+			DBusMenuEvent *ev = &g_array_index(queue->events, DBusMenuEvent, i);
+			event_send_single(queue->xml, ev->id, ev->event);
+		}
+	}
+	else if (queue->events->len > 1)
+	{
+		GVariantBuilder builder;
+		g_variant_builder_init(&builder, G_VARIANT_TYPE("a(isvu)"));
+		for (uint i = 0; i < queue->events->len; i++)
+		{
+			DBusMenuEvent *ev = &g_array_index(queue->events, DBusMenuEvent, i);
+			g_variant_builder_add(&builder,
+			                      "(isvu)",
+			                      ev->id,
+			                      ev->event,
+			                      g_variant_new_int32(0),
+			                      CURRENT_TIME);
+		}
+		GVariant *events = g_variant_ref_sink(g_variant_builder_end(&builder));
+		dbus_menu_xml_call_event_group(queue->xml,
+		                               events,
+		                               queue->cancellable,
+		                               event_group_cb,
+		                               events);
+	}
+	g_array_set_size(queue->events, 0);
+}
+
+static bool about_to_show_need_update(DBusMenuModel *model, bool need_update)
+{
+	// Model always has its first section, so emptiness is checked on it
+	need_update = need_update || dbus_menu_model_get_section_n_items(model, 0) == 0;
+	return need_update || dbus_menu_model_is_layout_update_required(model);
+}
+
+static void about_to_show_apply(DBusMenuModel *model, bool need_update)
+{
+	if (DBUS_MENU_IS_MODEL(model) && about_to_show_need_update(model, need_update))
+		dbus_menu_model_update_layout(model);
+}
+
+static void about_to_show_cb(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	DBusMenuModel *model    = DBUS_MENU_MODEL(user_data);
+	g_autoptr(GError) error = NULL;
+	gboolean need_update    = true;
+	dbus_menu_xml_call_about_to_show_finish(DBUS_MENU_XML(source_object),
+	                                        &need_update,
+	                                        res,
+	                                        &error);
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_object_unref(model);
+		return;
+	}
+	// Client may not implement AboutToShow at all, so layout is requested anyway
+	if (error != NULL)
+	{
+		g_debug("AboutToShow failed: %s", error->message);
+		need_update = true;
+	}
+	about_to_show_apply(model, need_update);
+	g_object_unref(model);
+}
+
+static void about_to_show_single(DBusMenuXml *xml, DBusMenuModel *model)
+{
+	uint id;
+	g_object_get(model, "parent-id", &id, NULL);
+	dbus_menu_xml_call_about_to_show(xml,
+	                                 id,
+	                                 dbus_menu_model_get_cancellable(model),
+	                                 about_to_show_cb,
+	                                 g_object_ref(model));
+}
+
+static void about_to_show_group_cb(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GPtrArray) models   = (GPtrArray *)user_data;
+	g_autoptr(GVariant) updates   = NULL;
+	g_autoptr(GVariant) id_errors = NULL;
+	g_autoptr(GError) error       = NULL;
+	g_autoptr(GHashTable) updated = NULL;
+	g_autoptr(GPtrArray) stale    = NULL;
+	DBusMenuXml *xml              = DBUS_MENU_XML(source_object);
+	DBusMenuEventQueue *queue     = event_queue_get(xml);
+	dbus_menu_xml_call_about_to_show_group_finish(xml, &updates, &id_errors, res, &error);
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+	if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+	{
+		// Client does not support groups, fall back to AboutToShow for each menu
+		g_debug("AboutToShowGroup failed: %s", error->message);
+		queue->group_unsupported = true;
+		for (uint i = 0; i < models->len; i++)
+			about_to_show_single(xml, DBUS_MENU_MODEL(g_ptr_array_index(models, i)));
+		return;
+	}
+	updated = g_hash_table_new(g_direct_hash, g_direct_equal);
+	// Other errors, like a timeout, are not remembered, and layouts are requested anyway
+	if (error != NULL)
+		g_debug("AboutToShowGroup failed: %s", error->message);
+	else
+	{
+		GVariantIter iter;
+		int id;
+		g_variant_iter_init(&iter, updates);
+		while (g_variant_iter_next(&iter, "i", &id))
+			g_hash_table_add(updated, GINT_TO_POINTER(id));
+	}
+	stale = g_ptr_array_new();
+	for (uint i = 0; i < models->len; i++)
+	{
+		DBusMenuModel *model = DBUS_MENU_MODEL(g_ptr_array_index(models, i));
+		uint model_id;
+		g_object_get(model, "parent-id", &model_id, NULL);
+		if (about_to_show_need_update(model,
+		                              error != NULL ||
+		                                  g_hash_table_contains(updated,
+		                                                        GUINT_TO_POINTER(model_id))))
+			g_ptr_array_add(stale, model);
+	}
+	dbus_menu_model_update_layouts(stale, queue->cancellable);
+}
+
+static void event_queue_send_about_to_show(DBusMenuEventQueue *queue)
+{
+	if (queue->shown->len == 1 || queue->group_unsupported)
+	{
+		for (uint i = 0; i < queue->shown->len; i++)
+			about_to_show_single(queue->xml,
+			                     DBUS_MENU_MODEL(g_ptr_array_index(queue->shown, i)));
+		g_ptr_array_set_size(queue->shown, 0);
+	}
+	else if (queue->shown->len > 1)
+	{
+		GVariantBuilder builder;
+		g_variant_builder_init(&builder, G_VARIANT_TYPE("ai"));
+		for (uint i = 0; i < queue->shown->len; i++)
+		{
+			uint id;
+			g_object_get(g_ptr_array_index(queue->shown, i), "parent-id", &id, NULL);
+			g_variant_builder_add(&builder, "i", id);
+		}
+		// Models are moved to callback
+		GPtrArray *models = queue->shown;
+		queue->shown      = g_ptr_array_new_with_free_func(g_object_unref);
+		dbus_menu_xml_call_about_to_show_group(queue->xml,
+		                                       g_variant_builder_end(&builder),
+		                                       queue->cancellable,
+		                                       about_to_show_group_cb,
+		                                       models);
+	}
+}
+
+static bool event_queue_flush(DBusMenuEventQueue *queue)
+{
+	queue->flush_source = 0;
+	event_queue_send_events(queue);
+	event_queue_send_about_to_show(queue);
+	return G_SOURCE_REMOVE;
+}
+
+static bool event_queue_contains(GPtrArray *models, DBusMenuModel *model)
+{
+	for (uint i = 0; i < models->len; i++)
+		if (g_ptr_array_index(models, i) == model)
+			return true;
+	return false;
+}
+
+// Preload is the same as opening: "opened" for a slice of submenus in one EventGroup, and
+// then one AboutToShowGroup for them
+static bool event_queue_flush_prefetch(DBusMenuEventQueue *queue)
+{
+	for (uint i = 0; i < DBUS_MENU_PREFETCH_SLICE && !g_sequence_is_empty(queue->prefetch);
+	     i++)
+	{
+		GSequenceIter *iter     = g_sequence_get_begin_iter(queue->prefetch);
+		DBusMenuPrefetch *entry = (DBusMenuPrefetch *)g_sequence_get(iter);
+		DBusMenuEvent ev        = { 0, DBUS_MENU_EVENT_OPENED };
+		g_object_get(entry->submenu, "parent-id", &ev.id, NULL);
+		g_array_append_val(queue->events, ev);
+		if (!event_queue_contains(queue->shown, entry->submenu))
+			g_ptr_array_add(queue->shown, g_object_ref(entry->submenu));
+		g_sequence_remove(iter);
+	}
+	event_queue_send_events(queue);
+	event_queue_send_about_to_show(queue);
+	if (!g_sequence_is_empty(queue->prefetch))
+		return G_SOURCE_CONTINUE;
+	queue->prefetch_source = 0;
+	return G_SOURCE_REMOVE;
+}
+
+// Submenus of an opened menu are the closest to pointer
+static void event_queue_prefetch_promote(DBusMenuEventQueue *queue, DBusMenuModel *model)
+{
+	GSequenceIter *iter = g_sequence_get_begin_iter(queue->prefetch);
+	while (!g_sequence_iter_is_end(iter))
+	{
+		GSequenceIter *next     = g_sequence_iter_next(iter);
+		DBusMenuPrefetch *entry = (DBusMenuPrefetch *)g_sequence_get(iter);
+		if (entry->item->parent_model == model && entry->priority > PREFETCH_NEAR_POINTER)
+		{
+			entry->priority = PREFETCH_NEAR_POINTER;
+			g_sequence_sort_changed(iter, (GCompareDataFunc)prefetch_compare, NULL);
+		}
+		iter = next;
+	}
+}
+
+static int event_queue_prefetch_priority(DBusMenuEventQueue *queue, DBusMenuItem *item)
+{
+	uint parent_id = UINT_MAX;
+	if (item->parent_model == NULL)
+		return PREFETCH_OTHER;
+	g_object_get(item->parent_model, "parent-id", &parent_id, NULL);
+	if (parent_id == 0)
+		return PREFETCH_TOPLEVEL;
+	if (item->parent_model == queue->pointer_model)
+		return PREFETCH_NEAR_POINTER;
+	return PREFETCH_OTHER;
+}
+
+static void event_queue_schedule(DBusMenuEventQueue *queue)
+{
+	if (queue->flush_source == 0)
+		queue->flush_source = g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+		                                      (GSourceFunc)event_queue_flush,
+		                                      queue,
+		                                      NULL);
+}
+
+G_GNUC_INTERNAL void dbus_menu_event_set_cancellable(DBusMenuXml *xml, GCancellable *cancellable)
+{
+	g_return_if_fail(DBUS_MENU_IS_XML(xml));
+	DBusMenuEventQueue *queue = event_queue_get(xml);
+	g_set_object(&queue->cancellable, cancellable);
+}
+
+G_GNUC_INTERNAL void dbus_menu_event_send(DBusMenuXml *xml, uint id, const char *event)
+{
+	g_return_if_fail(DBUS_MENU_IS_XML(xml));
+	DBusMenuEventQueue *queue = event_queue_get(xml);
+	DBusMenuEvent ev          = { id, event };
+	g_array_append_val(queue->events, ev);
+	event_queue_schedule(queue);
+}
+
+G_GNUC_INTERNAL void dbus_menu_event_about_to_show(DBusMenuXml *xml, DBusMenuModel *model)
+{
+	g_return_if_fail(DBUS_MENU_IS_XML(xml));
+	g_return_if_fail(DBUS_MENU_IS_MODEL(model));
+	DBusMenuEventQueue *queue = event_queue_get(xml);
+	if (queue->pointer_model != model)
+	{
+		queue->pointer_model = model;
+		event_queue_prefetch_promote(queue, model);
+	}
+	if (event_queue_contains(queue->shown, model))
+		return;
+	g_ptr_array_add(queue->shown, g_object_ref(model));
+	event_queue_schedule(queue);
+}
+
+G_GNUC_INTERNAL void dbus_menu_event_prefetch(DBusMenuXml *xml, DBusMenuItem *item,
+                                              DBusMenuModel *submenu)
+{
+	g_return_if_fail(DBUS_MENU_IS_XML(xml));
+	g_return_if_fail(DBUS_MENU_IS_MODEL(submenu));
+	if (item->prefetch != NULL)
+		return;
+	DBusMenuEventQueue *queue = event_queue_get(xml);
+	DBusMenuPrefetch *entry   = g_slice_new0(DBusMenuPrefetch);
+	entry->item               = item;
+	entry->submenu            = g_object_ref(submenu);
+	entry->priority           = event_queue_prefetch_priority(queue, item);
+	entry->serial             = queue->prefetch_serial++;
+	item->prefetch = g_sequence_insert_sorted(queue->prefetch,
+	                                          entry,
+	                                          (GCompareDataFunc)prefetch_compare,
+	                                          NULL);
+	if (queue->prefetch_source == 0)
+		queue->prefetch_source = g_idle_add_full(G_PRIORITY_LOW,
+		                                         (GSourceFunc)event_queue_flush_prefetch,
+		                                         queue,
+		                                         NULL);
+}
+
+G_GNUC_INTERNAL void dbus_menu_event_prefetch_cancel(DBusMenuItem *item)
+{
+	// Entry clears the link when it is freed
+	if (item->prefetch != NULL)
+		g_sequence_remove((GSequenceIter *)item->prefetch);
+}
+
 static void activate_ordinary_cb(GSimpleAction *action, GVariant *parameter, gpointer user_data)
 {
 	DBusMenuXml *xml = DBUS_MENU_XML(user_data);
 	u_int32_t id;
 	sscanf(g_action_get_name(G_ACTION(action)), ACTION_PREFIX "%u", &id);
 	// use CURRENT_TIME instead of gtk_get_current_event_time to avoid linking to GTK.
-	dbus_menu_xml_call_event_sync(xml,
-	                              id,
-	                              "clicked",
-	                              g_variant_new("v", g_variant_new_int32(0)),
-	                              CURRENT_TIME,
-	                              NULL,
-	                              NULL);
+	dbus_menu_event_send(xml, id, DBUS_MENU_EVENT_CLICKED);
 }
 
 static void activate_checkbox_cb(GSimpleAction *action, GVariant *parameter, gpointer user_data)
@@ -45,13 +473,7 @@ static void activate_checkbox_cb(GSimpleAction *action, GVariant *parameter, gpo
 	sscanf(g_action_get_name(G_ACTION(action)), ACTION_PREFIX "%u", &id);
 	g_autoptr(GVariant) state = g_action_get_state(G_ACTION(action));
 	// use CURRENT_TIME instead of gtk_get_current_event_time to avoid linking to GTK.
-	dbus_menu_xml_call_event_sync(xml,
-	                              id,
-	                              "clicked",
-	                              g_variant_new("v", g_variant_new_int32(0)),
-	                              CURRENT_TIME,
-	                              NULL,
-	                              NULL);
+	dbus_menu_event_send(xml, id, DBUS_MENU_EVENT_CLICKED);
 	g_action_change_state(G_ACTION(action),
 	                      g_variant_new_boolean(!g_variant_get_boolean(state)));
 }
@@ -63,13 +485,7 @@ static void state_radio_cb(GSimpleAction *action, GVariant *parameter, gpointer
 	uint id;
 	sscanf(id_str, ACTION_PREFIX "%u", &id);
 	// use CURRENT_TIME instead of gtk_get_current_event_time to avoid linking to GTK.
-	dbus_menu_xml_call_event_sync(xml,
-	                              id,
-	                              "clicked",
-	                              g_variant_new("v", g_variant_new_int32(0)),
-	                              CURRENT_TIME,
-	                              NULL,
-	                              NULL);
+	dbus_menu_event_send(xml, id, DBUS_MENU_EVENT_CLICKED);
 	g_simple_action_set_state(action, parameter);
 }
 
@@ -111,38 +527,22 @@ static GAction *dbus_menu_action_new(DBusMenuXml *xml, u_int32_t id, DBusMenuAct
 static void state_submenu_cb(GSimpleAction *action, GVariant *parameter, gpointer user_data)
 {
 	g_return_if_fail(DBUS_MENU_IS_MODEL(user_data));
-	DBusMenuModel *model = DBUS_MENU_MODEL(user_data);
-	DBusMenuXml *xml;
+	DBusMenuModel *model       = DBUS_MENU_MODEL(user_data);
+	g_autoptr(DBusMenuXml) xml = NULL;
 	u_int32_t id;
 	g_object_get(model, "parent-id", &id, "xml", &xml, NULL);
 	bool request_open = g_variant_get_boolean(parameter);
 	GVariant *statev  = g_action_get_state(G_ACTION(action));
 	bool opened       = g_variant_get_boolean(statev);
 	g_variant_unref(statev);
-	bool need_update = true;
 	if (request_open && !opened)
 	{
 		// Use opened before actual open. For Firefox.
-		dbus_menu_xml_call_event_sync(xml,
-		                              id,
-		                              "opened",
-		                              g_variant_new("v", g_variant_new_int32(0)),
-		                              CURRENT_TIME,
-		                              NULL,
-		                              NULL);
-		dbus_menu_xml_call_about_to_show_sync(xml,
-		                                      id,
-		                                      (gboolean *)&need_update,
-		                                      NULL,
-		                                      NULL);
-		if (g_menu_model_get_n_items(G_MENU_MODEL(model)) == 0)
-			need_update = true;
-		need_update = need_update || dbus_menu_model_is_layout_update_required(model);
-		if (need_update)
+		// Layout is updated from AboutToShow reply, menu is shown without waiting for it.
+		if (xml != NULL)
 		{
-			// TODD: Populate layout after request;
-			if (DBUS_MENU_IS_MODEL(model))
-				dbus_menu_model_update_layout(model);
+			dbus_menu_event_send(xml, id, DBUS_MENU_EVENT_OPENED);
+			dbus_menu_event_about_to_show(xml, model);
 		}
 		g_simple_action_set_state(action, g_variant_new_boolean(true));
 		// TODO: change state to false after menu closing, not by time
@@ -151,7 +551,7 @@ static void state_submenu_cb(GSimpleAction *action, GVariant *parameter, gpointe
 	else if (request_open)
 	{
 		g_simple_action_set_state(action, g_variant_new_boolean(true));
-		need_update = dbus_menu_model_is_layout_update_required(model);
+		bool need_update = dbus_menu_model_is_layout_update_required(model);
 		if (need_update)
 		{
 			// TODD: Populate layout after request;
@@ -161,13 +561,8 @@ static void state_submenu_cb(GSimpleAction *action, GVariant *parameter, gpointe
 	}
 	else
 	{
-		dbus_menu_xml_call_event_sync(xml,
-		                              id,
-		                              "closed",
-		                              g_variant_new("v", g_variant_new_int32(0)),
-		                              CURRENT_TIME,
-		                              NULL,
-		                              NULL);
+		if (xml != NULL)
+			dbus_menu_event_send(xml, id, DBUS_MENU_EVENT_CLOSED);
 		g_simple_action_set_state(action, g_variant_new_boolean(false));
 	}
 }
@@ -40,6 +40,14 @@ G_GNUC_INTERNAL void dbus_menu_action_replace_signals(GAction *action, DBusMenuX
 G_GNUC_INTERNAL void dbus_menu_action_lock(GAction *action);
 G_GNUC_INTERNAL void dbus_menu_action_unlock(GAction *action);
 
+G_GNUC_INTERNAL void dbus_menu_event_set_cancellable(DBusMenuXml *xml,
+                                                     GCancellable *cancellable);
+G_GNUC_INTERNAL void dbus_menu_event_send(DBusMenuXml *xml, uint id, const char *event);
+G_GNUC_INTERNAL void dbus_menu_event_about_to_show(DBusMenuXml *xml, DBusMenuModel *model);
+G_GNUC_INTERNAL void dbus_menu_event_prefetch(DBusMenuXml *xml, DBusMenuItem *item,
+                                              DBusMenuModel *submenu);
+G_GNUC_INTERNAL void dbus_menu_event_prefetch_cancel(DBusMenuItem *item);
+
 G_END_DECLS
 
 #endif // UTILS_H
@@ -46,6 +46,7 @@ struct _UnityGtkActionGroup
 	GActionGroup *old_group;
 	GHashTable *actions_by_name;
 	GHashTable *names_by_radio_menu_item;
+	GHashTable *radio_menu_items_by_group;
 };
 
 GType unity_gtk_action_group_get_type(void);
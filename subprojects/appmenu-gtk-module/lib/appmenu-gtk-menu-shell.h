@@ -46,10 +46,12 @@ struct _UnityGtkMenuShell
 	GtkMenuShell *menu_shell;
 	gboolean has_mnemonics;
 	GPtrArray *items;
-	GPtrArray *sections;
+	GSequence *sections;
 	GSequence *visible_indices;
 	GSequence *separator_indices;
 	UnityGtkActionGroup *action_group;
+	GHashTable *dirty_items;
+	guint flush_idle_id;
 };
 
 GType unity_gtk_menu_shell_get_type(void);
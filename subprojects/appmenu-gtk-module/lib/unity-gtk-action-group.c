@@ -184,12 +184,20 @@ static void unity_gtk_action_group_dispose(GObject *object)
 	UnityGtkActionGroup *group;
 	GHashTable *actions_by_name;
 	GHashTable *names_by_radio_menu_item;
+	GHashTable *radio_menu_items_by_group;
 
 	g_return_if_fail(UNITY_GTK_IS_ACTION_GROUP(object));
 
-	group                    = UNITY_GTK_ACTION_GROUP(object);
-	actions_by_name          = group->actions_by_name;
-	names_by_radio_menu_item = group->names_by_radio_menu_item;
+	group                     = UNITY_GTK_ACTION_GROUP(object);
+	actions_by_name           = group->actions_by_name;
+	names_by_radio_menu_item  = group->names_by_radio_menu_item;
+	radio_menu_items_by_group = group->radio_menu_items_by_group;
+
+	if (radio_menu_items_by_group != NULL)
+	{
+		group->radio_menu_items_by_group = NULL;
+		g_hash_table_unref(radio_menu_items_by_group);
+	}
 
 	if (names_by_radio_menu_item != NULL)
 	{
@@ -694,6 +702,7 @@ static void unity_gtk_action_group_init(UnityGtkActionGroup *self)
 	    g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_object_unref);
 	self->names_by_radio_menu_item =
 	    g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	self->radio_menu_items_by_group = g_hash_table_new(g_direct_hash, g_direct_equal);
 }
 
 /**
@@ -940,6 +949,41 @@ static char *unity_gtk_action_group_get_state_name(UnityGtkActionGroup *group,
 	return name;
 }
 
+static gboolean g_pointer_is_value(gpointer key, gpointer value, gpointer user_data)
+{
+	return value == user_data;
+}
+
+static void unity_gtk_action_group_handle_radio_group_changed(GtkRadioMenuItem *radio_menu_item,
+                                                              gpointer user_data);
+
+/*
+ * Forgets every group list head remembered for this radio menu item. Heads
+ * change whenever a member joins or leaves, so an item can be remembered under
+ * heads which are not its group's head any more.
+ */
+static void unity_gtk_action_group_forget_radio_menu_item(UnityGtkActionGroup *group,
+                                                          GtkRadioMenuItem *radio_menu_item)
+{
+	g_signal_handlers_disconnect_by_func(radio_menu_item,
+	                                     unity_gtk_action_group_handle_radio_group_changed,
+	                                     group);
+
+	if (group->radio_menu_items_by_group != NULL)
+		g_hash_table_foreach_remove(group->radio_menu_items_by_group,
+		                            g_pointer_is_value,
+		                            radio_menu_item);
+}
+
+static void unity_gtk_action_group_handle_radio_group_changed(GtkRadioMenuItem *radio_menu_item,
+                                                              gpointer user_data)
+{
+	g_return_if_fail(UNITY_GTK_IS_ACTION_GROUP(user_data));
+
+	unity_gtk_action_group_forget_radio_menu_item(UNITY_GTK_ACTION_GROUP(user_data),
+	                                              radio_menu_item);
+}
+
 void unity_gtk_action_group_connect_item(UnityGtkActionGroup *group, UnityGtkMenuItem *item)
 {
 	g_return_if_fail(UNITY_GTK_IS_ACTION_GROUP(group));
@@ -975,8 +1019,25 @@ void unity_gtk_action_group_connect_item(UnityGtkActionGroup *group, UnityGtkMen
 
 			if (action_name == NULL)
 			{
-				GtkRadioMenuItem *last_radio_menu_item = NULL;
-				GSList *iter = gtk_radio_menu_item_get_group(radio_menu_item);
+				GSList *radio_group = gtk_radio_menu_item_get_group(radio_menu_item);
+				GtkRadioMenuItem *last_radio_menu_item =
+				    g_hash_table_lookup(group->radio_menu_items_by_group, radio_group);
+				GSList *iter = radio_group;
+
+				/*
+				 * A group's list head is shared by all of its members, so we remember
+				 * one named member per head. The head may be freed and reused by
+				 * another group, so only trust the member if it is still connected
+				 * and still in this group.
+				 */
+				if (last_radio_menu_item != NULL &&
+				    g_hash_table_contains(group->names_by_radio_menu_item,
+				                          last_radio_menu_item) &&
+				    gtk_radio_menu_item_get_group(last_radio_menu_item) == radio_group)
+					action_name = g_hash_table_lookup(group->names_by_radio_menu_item,
+					                                  last_radio_menu_item);
+				else
+					last_radio_menu_item = NULL;
 
 				while (action_name == NULL && iter != NULL)
 				{
@@ -1008,6 +1069,16 @@ void unity_gtk_action_group_connect_item(UnityGtkActionGroup *group, UnityGtkMen
 					g_hash_table_insert(group->names_by_radio_menu_item,
 					                    radio_menu_item,
 					                    g_strdup(action_name));
+
+				g_hash_table_insert(group->radio_menu_items_by_group,
+				                    radio_group,
+				                    radio_menu_item);
+				g_signal_connect_object(radio_menu_item,
+				                        "group-changed",
+				                        G_CALLBACK(
+				                            unity_gtk_action_group_handle_radio_group_changed),
+				                        group,
+				                        0);
 			}
 
 			action = g_hash_table_lookup(group->actions_by_name, action_name);
@@ -1016,7 +1087,7 @@ void unity_gtk_action_group_connect_item(UnityGtkActionGroup *group, UnityGtkMen
 				action = new_action = unity_gtk_action_new_radio(action_name);
 
 			state_name = unity_gtk_action_group_get_state_name(group, item);
-			g_hash_table_insert(action->items_by_name, state_name, g_object_ref(item));
+			unity_gtk_action_add_item(action, state_name, item);
 		}
 		else if (!unity_gtk_menu_item_is_separator(item))
 		{
@@ -1045,6 +1116,7 @@ void unity_gtk_action_group_connect_item(UnityGtkActionGroup *group, UnityGtkMen
 				char *subname = unity_gtk_action_group_get_action_name(group, item);
 				unity_gtk_action_set_subname(new_action, subname);
 				g_free(subname);
+				unity_gtk_menu_item_invalidate_attributes(item);
 
 				if (group->actions_by_name != NULL)
 					g_hash_table_insert(group->actions_by_name,
@@ -1076,26 +1148,24 @@ void unity_gtk_action_group_disconnect_item(UnityGtkActionGroup *group, UnityGtk
 		{
 			if (group->names_by_radio_menu_item != NULL)
 			{
-				const char *name = NULL;
-				GHashTableIter iter;
-				gpointer key;
-				gpointer value;
-
-				g_hash_table_iter_init(&iter, action->items_by_name);
-				while (name == NULL && g_hash_table_iter_next(&iter, &key, &value))
-					if (value == item)
-						name = key;
+				const char *name = unity_gtk_action_get_item_name(action, item);
 
 				if (name != NULL)
 				{
-					g_hash_table_remove(action->items_by_name, name);
+					GtkMenuItem *menu_item = item->menu_item;
+
+					unity_gtk_action_remove_item(action, item);
 
 					if (group->names_by_radio_menu_item != NULL)
 						g_hash_table_remove(group->names_by_radio_menu_item,
-						                    item->menu_item);
+						                    menu_item);
 					else
 						g_warn_if_reached();
 
+					if (GTK_IS_RADIO_MENU_ITEM(menu_item))
+						unity_gtk_action_group_forget_radio_menu_item(
+						    group, GTK_RADIO_MENU_ITEM(menu_item));
+
 					if (g_hash_table_size(action->items_by_name) == 0)
 					{
 						/* Remove the submenu action used to detect opening
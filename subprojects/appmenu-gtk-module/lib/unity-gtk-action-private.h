@@ -42,6 +42,7 @@ struct _UnityGtkAction
 	char *subname;
 	UnityGtkMenuItem *item;
 	GHashTable *items_by_name;
+	GHashTable *names_by_item;
 };
 
 GType unity_gtk_action_get_type(void) G_GNUC_INTERNAL;
@@ -56,6 +57,14 @@ void unity_gtk_action_set_subname(UnityGtkAction *action, const char *subname) G
 
 void unity_gtk_action_set_item(UnityGtkAction *action, UnityGtkMenuItem *item) G_GNUC_INTERNAL;
 
+void unity_gtk_action_add_item(UnityGtkAction *action, char *name,
+                               UnityGtkMenuItem *item) G_GNUC_INTERNAL;
+
+void unity_gtk_action_remove_item(UnityGtkAction *action, UnityGtkMenuItem *item) G_GNUC_INTERNAL;
+
+const char *unity_gtk_action_get_item_name(UnityGtkAction *action,
+                                           UnityGtkMenuItem *item) G_GNUC_INTERNAL;
+
 void unity_gtk_action_print(UnityGtkAction *action, guint indent) G_GNUC_INTERNAL;
 
 G_END_DECLS
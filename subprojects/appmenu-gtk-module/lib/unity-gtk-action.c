@@ -25,11 +25,19 @@ static void unity_gtk_action_dispose(GObject *object)
 {
 	UnityGtkAction *action;
 	GHashTable *items_by_name;
+	GHashTable *names_by_item;
 
 	g_return_if_fail(UNITY_GTK_IS_ACTION(object));
 
 	action        = UNITY_GTK_ACTION(object);
 	items_by_name = action->items_by_name;
+	names_by_item = action->names_by_item;
+
+	if (names_by_item != NULL)
+	{
+		action->names_by_item = NULL;
+		g_hash_table_unref(names_by_item);
+	}
 
 	if (items_by_name != NULL)
 	{
@@ -72,6 +80,8 @@ UnityGtkAction *unity_gtk_action_new_radio(const char *name)
 	unity_gtk_action_set_name(action, name);
 	action->items_by_name =
 	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+	/* Reverse map of items_by_name, the names are owned by items_by_name. */
+	action->names_by_item = g_hash_table_new(g_direct_hash, g_direct_equal);
 
 	return action;
 }
@@ -113,6 +123,52 @@ void unity_gtk_action_set_item(UnityGtkAction *action, UnityGtkMenuItem *item)
 	}
 }
 
+void unity_gtk_action_add_item(UnityGtkAction *action, char *name, UnityGtkMenuItem *item)
+{
+	UnityGtkMenuItem *old_item;
+
+	g_return_if_fail(UNITY_GTK_IS_ACTION(action));
+	g_return_if_fail(action->items_by_name != NULL && action->names_by_item != NULL);
+	g_return_if_fail(name != NULL);
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+
+	unity_gtk_action_remove_item(action, item);
+
+	old_item = g_hash_table_lookup(action->items_by_name, name);
+
+	if (old_item != NULL)
+		g_hash_table_remove(action->names_by_item, old_item);
+
+	g_hash_table_replace(action->items_by_name, name, g_object_ref(item));
+	g_hash_table_insert(action->names_by_item, item, name);
+}
+
+void unity_gtk_action_remove_item(UnityGtkAction *action, UnityGtkMenuItem *item)
+{
+	const char *name;
+
+	g_return_if_fail(UNITY_GTK_IS_ACTION(action));
+	g_return_if_fail(action->items_by_name != NULL && action->names_by_item != NULL);
+
+	name = g_hash_table_lookup(action->names_by_item, item);
+
+	if (name != NULL)
+	{
+		g_hash_table_remove(action->names_by_item, item);
+		g_hash_table_remove(action->items_by_name, name);
+	}
+}
+
+const char *unity_gtk_action_get_item_name(UnityGtkAction *action, UnityGtkMenuItem *item)
+{
+	g_return_val_if_fail(UNITY_GTK_IS_ACTION(action), NULL);
+
+	if (action->names_by_item == NULL)
+		return NULL;
+
+	return g_hash_table_lookup(action->names_by_item, item);
+}
+
 void unity_gtk_action_print(UnityGtkAction *action, guint indent)
 {
 	char *space;
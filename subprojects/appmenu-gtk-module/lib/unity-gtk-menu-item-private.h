@@ -48,6 +48,9 @@ struct _UnityGtkMenuItem
 	GtkLabel *first_label;
 	GtkLabel *second_label;
 	char *label_label;
+	GtkImage *image;
+	gulong accel_map_handler_id;
+	GHashTable *attributes;
 };
 
 GType unity_gtk_menu_item_get_type(void) G_GNUC_INTERNAL;
@@ -59,6 +62,8 @@ UnityGtkMenuShell *unity_gtk_menu_item_get_child_shell(UnityGtkMenuItem *item) G
 
 void unity_gtk_menu_item_set_action(UnityGtkMenuItem *item, UnityGtkAction *action) G_GNUC_INTERNAL;
 
+void unity_gtk_menu_item_invalidate_attributes(UnityGtkMenuItem *item) G_GNUC_INTERNAL;
+
 const char *unity_gtk_menu_item_get_label(UnityGtkMenuItem *item) G_GNUC_INTERNAL;
 
 GIcon *unity_gtk_menu_item_get_icon(UnityGtkMenuItem *item) G_GNUC_INTERNAL;
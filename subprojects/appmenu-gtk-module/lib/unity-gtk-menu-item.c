@@ -327,11 +327,14 @@ static GIcon *gtk_image_get_icon(GtkImage *image)
 	return icon;
 }
 
+static void unity_gtk_menu_item_connect_accel_map(UnityGtkMenuItem *item);
+
 static void unity_gtk_menu_item_handle_item_notify(GObject *object, GParamSpec *pspec,
                                                    gpointer user_data)
 {
 	static const char *label_name;
 	static const char *use_underline_name;
+	static const char *accel_path_name;
 
 	UnityGtkMenuItem *item;
 	UnityGtkMenuShell *parent_shell;
@@ -351,9 +354,14 @@ static void unity_gtk_menu_item_handle_item_notify(GObject *object, GParamSpec *
 		label_name = g_intern_static_string("label");
 	if (G_UNLIKELY(use_underline_name == NULL))
 		use_underline_name = g_intern_static_string("use-underline");
+	if (G_UNLIKELY(accel_path_name == NULL))
+		accel_path_name = g_intern_static_string("accel-path");
 
 	name = g_param_spec_get_name(pspec);
 
+	if (name == accel_path_name)
+		unity_gtk_menu_item_connect_accel_map(item);
+
 	if (name != label_name && name != use_underline_name)
 		unity_gtk_menu_shell_handle_item_notify(parent_shell, item, name);
 }
@@ -443,6 +451,121 @@ static gboolean unity_gtk_menu_item_connect_labels(UnityGtkMenuItem *item)
 	return FALSE;
 }
 
+static void unity_gtk_menu_item_handle_image_notify(GObject *object, GParamSpec *pspec,
+                                                    gpointer user_data)
+{
+	UnityGtkMenuItem *item;
+	UnityGtkMenuShell *parent_shell;
+
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(user_data));
+
+	item         = UNITY_GTK_MENU_ITEM(user_data);
+	parent_shell = item->parent_shell;
+
+	g_return_if_fail(parent_shell != NULL);
+
+	/* The exported icon is built from the image contents. */
+	unity_gtk_menu_shell_handle_item_notify(parent_shell, item, "image");
+}
+
+static void unity_gtk_menu_item_disconnect_image(UnityGtkMenuItem *item)
+{
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+
+	if (item->image != NULL)
+	{
+		g_signal_handlers_disconnect_by_data(item->image, item);
+		item->image = NULL;
+	}
+}
+
+static gboolean unity_gtk_menu_item_connect_image(UnityGtkMenuItem *item)
+{
+	GtkImage *image = NULL;
+
+	g_return_val_if_fail(UNITY_GTK_IS_MENU_ITEM(item), FALSE);
+
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	if (item->menu_item != NULL && !GTK_IS_IMAGE_MENU_ITEM(item->menu_item))
+		image = gtk_menu_item_get_nth_image(item->menu_item, 0);
+	G_GNUC_END_IGNORE_DEPRECATIONS
+
+	if (image != item->image)
+	{
+		unity_gtk_menu_item_disconnect_image(item);
+
+		item->image = image;
+
+		if (item->image != NULL)
+			g_signal_connect(item->image,
+			                 "notify",
+			                 G_CALLBACK(unity_gtk_menu_item_handle_image_notify),
+			                 item);
+
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void unity_gtk_menu_item_handle_accel_map_changed(GtkAccelMap *accel_map,
+                                                         const char *accel_path, guint accel_key,
+                                                         GdkModifierType accel_mods,
+                                                         gpointer user_data)
+{
+	UnityGtkMenuItem *item;
+	UnityGtkMenuShell *parent_shell;
+
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(user_data));
+
+	item         = UNITY_GTK_MENU_ITEM(user_data);
+	parent_shell = item->parent_shell;
+
+	g_return_if_fail(parent_shell != NULL);
+
+	unity_gtk_menu_shell_handle_item_notify(parent_shell, item, "accel-path");
+}
+
+static void unity_gtk_menu_item_disconnect_accel_map(UnityGtkMenuItem *item)
+{
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+
+	if (item->accel_map_handler_id != 0)
+	{
+		g_signal_handler_disconnect(gtk_accel_map_get(), item->accel_map_handler_id);
+		item->accel_map_handler_id = 0;
+	}
+}
+
+/*
+ * The accel map emits "changed" detailed by the accel path, so each item
+ * only hears about its own path.
+ */
+static void unity_gtk_menu_item_connect_accel_map(UnityGtkMenuItem *item)
+{
+	const char *accel_path = NULL;
+
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+
+	unity_gtk_menu_item_disconnect_accel_map(item);
+
+	if (item->menu_item != NULL)
+		accel_path = gtk_menu_item_get_accel_path(item->menu_item);
+
+	if (accel_path != NULL)
+	{
+		char *signal = g_strdup_printf("changed::%s", accel_path);
+
+		item->accel_map_handler_id =
+		    g_signal_connect(gtk_accel_map_get(),
+		                     signal,
+		                     G_CALLBACK(unity_gtk_menu_item_handle_accel_map_changed),
+		                     item);
+
+		g_free(signal);
+	}
+}
+
 static void unity_gtk_menu_item_handle_add_or_remove(GtkContainer *container, GtkWidget *widget,
                                                      gpointer user_data)
 {
@@ -455,6 +578,9 @@ static void unity_gtk_menu_item_handle_add_or_remove(GtkContainer *container, Gt
 	/* just ignore the case when parent_shell is NULL */
 	if (item->parent_shell != NULL && unity_gtk_menu_item_connect_labels(item))
 		unity_gtk_menu_shell_handle_item_notify(item->parent_shell, item, "label");
+
+	if (item->parent_shell != NULL && unity_gtk_menu_item_connect_image(item))
+		unity_gtk_menu_shell_handle_item_notify(item->parent_shell, item, "image");
 }
 
 static void unity_gtk_menu_item_handle_accel_closures_changed(GtkWidget *widget, gpointer user_data)
@@ -481,6 +607,8 @@ static void unity_gtk_menu_item_set_menu_item(UnityGtkMenuItem *item, GtkMenuIte
 		UnityGtkMenuShell *child_shell = item->child_shell;
 
 		unity_gtk_menu_item_disconnect_labels(item);
+		unity_gtk_menu_item_disconnect_image(item);
+		unity_gtk_menu_item_disconnect_accel_map(item);
 
 		if (item->menu_item != NULL)
 			g_signal_handlers_disconnect_by_data(item->menu_item, item);
@@ -525,6 +653,8 @@ static void unity_gtk_menu_item_set_menu_item(UnityGtkMenuItem *item, GtkMenuIte
 		}
 
 		unity_gtk_menu_item_connect_labels(item);
+		unity_gtk_menu_item_connect_image(item);
+		unity_gtk_menu_item_connect_accel_map(item);
 	}
 }
 
@@ -562,6 +692,8 @@ static void unity_gtk_menu_item_finalize(GObject *object)
 	g_free(item->label_label);
 	item->label_label = NULL;
 
+	unity_gtk_menu_item_invalidate_attributes(item);
+
 	G_OBJECT_CLASS(unity_gtk_menu_item_parent_class)->finalize(object);
 }
 
@@ -653,6 +785,19 @@ void unity_gtk_menu_item_set_action(UnityGtkMenuItem *item, UnityGtkAction *acti
 
 		if (action != NULL)
 			item->action = g_object_ref(action);
+
+		unity_gtk_menu_item_invalidate_attributes(item);
+	}
+}
+
+void unity_gtk_menu_item_invalidate_attributes(UnityGtkMenuItem *item)
+{
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+
+	if (item->attributes != NULL)
+	{
+		g_hash_table_unref(item->attributes);
+		item->attributes = NULL;
 	}
 }
 
@@ -39,13 +39,14 @@ struct _UnityGtkMenuSection
 
 	/*< private >*/
 	UnityGtkMenuShell *parent_shell;
-	guint section_index;
+	GSequenceIter *section_iter;
 };
 
 GType unity_gtk_menu_section_get_type(void) G_GNUC_INTERNAL;
 
-UnityGtkMenuSection *unity_gtk_menu_section_new(UnityGtkMenuShell *parent_shell,
-                                                guint section_index) G_GNUC_INTERNAL;
+UnityGtkMenuSection *unity_gtk_menu_section_new(UnityGtkMenuShell *parent_shell) G_GNUC_INTERNAL;
+
+guint unity_gtk_menu_section_get_index(UnityGtkMenuSection *section) G_GNUC_INTERNAL;
 
 GSequenceIter *unity_gtk_menu_section_get_begin_iter(UnityGtkMenuSection *section) G_GNUC_INTERNAL;
 
@@ -108,9 +108,20 @@ static void unity_gtk_menu_section_get_item_attributes(GMenuModel *model, gint i
 
 	g_return_if_fail(parent_shell != NULL);
 
-	iter   = unity_gtk_menu_section_get_iter(section, item_index);
-	index  = GPOINTER_TO_UINT(g_sequence_get(iter));
-	item   = unity_gtk_menu_shell_get_item(parent_shell, index);
+	iter  = unity_gtk_menu_section_get_iter(section, item_index);
+	index = GPOINTER_TO_UINT(g_sequence_get(iter));
+	item  = unity_gtk_menu_shell_get_item(parent_shell, index);
+
+	/*
+	 * The table is built once and shared with every caller until the item
+	 * changes, so re-exporting an unchanged item only costs a reference.
+	 */
+	if (item->attributes != NULL)
+	{
+		*attributes = g_hash_table_ref(item->attributes);
+		return;
+	}
+
 	label  = unity_gtk_menu_item_get_label(item);
 	icon   = unity_gtk_menu_item_get_icon(item);
 	action = item->action;
@@ -140,16 +151,7 @@ static void unity_gtk_menu_section_get_item_attributes(GMenuModel *model, gint i
 
 			if (action->items_by_name != NULL)
 			{
-				GHashTableIter iter;
-				gpointer key;
-				gpointer value;
-				const char *target = NULL;
-
-				g_hash_table_iter_init(&iter, action->items_by_name);
-				while (target == NULL &&
-				       g_hash_table_iter_next(&iter, &key, &value))
-					if (value == item)
-						target = key;
+				const char *target = unity_gtk_action_get_item_name(action, item);
 
 				if (target != NULL)
 					g_hash_table_insert(*attributes,
@@ -251,6 +253,8 @@ static void unity_gtk_menu_section_get_item_attributes(GMenuModel *model, gint i
 
 		g_free(accel_name);
 	}
+
+	item->attributes = g_hash_table_ref(*attributes);
 }
 
 static void unity_gtk_menu_section_get_item_links(GMenuModel *model, gint item_index,
@@ -298,17 +302,26 @@ static void unity_gtk_menu_section_init(UnityGtkMenuSection *self)
 {
 }
 
-UnityGtkMenuSection *unity_gtk_menu_section_new(UnityGtkMenuShell *parent_shell,
-                                                guint section_index)
+UnityGtkMenuSection *unity_gtk_menu_section_new(UnityGtkMenuShell *parent_shell)
 {
 	UnityGtkMenuSection *section = g_object_new(UNITY_GTK_TYPE_MENU_SECTION, NULL);
 
 	unity_gtk_menu_section_set_parent_shell(section, parent_shell);
-	section->section_index = section_index;
 
 	return section;
 }
 
+guint unity_gtk_menu_section_get_index(UnityGtkMenuSection *section)
+{
+	g_return_val_if_fail(UNITY_GTK_IS_MENU_SECTION(section), 0);
+
+	/* section_iter is the section's node in the parent shell's section sequence. */
+	if (section->section_iter == NULL)
+		return 0;
+
+	return g_sequence_iter_get_position(section->section_iter);
+}
+
 GSequenceIter *unity_gtk_menu_section_get_begin_iter(UnityGtkMenuSection *section)
 {
 	UnityGtkMenuShell *parent_shell;
@@ -326,7 +339,7 @@ GSequenceIter *unity_gtk_menu_section_get_begin_iter(UnityGtkMenuSection *sectio
 
 	separator_indices = unity_gtk_menu_shell_get_separator_indices(parent_shell);
 	visible_indices   = unity_gtk_menu_shell_get_visible_indices(parent_shell);
-	section_index     = section->section_index;
+	section_index     = unity_gtk_menu_section_get_index(section);
 
 	if (section_index > 0)
 		separator_iter = g_sequence_get_iter_at_pos(separator_indices, section_index - 1);
@@ -361,7 +374,8 @@ GSequenceIter *unity_gtk_menu_section_get_end_iter(UnityGtkMenuSection *section)
 
 	separator_indices = unity_gtk_menu_shell_get_separator_indices(parent_shell);
 	visible_indices   = unity_gtk_menu_shell_get_visible_indices(parent_shell);
-	separator_iter    = g_sequence_get_iter_at_pos(separator_indices, section->section_index);
+	separator_iter    = g_sequence_get_iter_at_pos(separator_indices,
+	                                               unity_gtk_menu_section_get_index(section));
 
 	if (g_sequence_iter_is_end(separator_iter))
 		separator_iter = NULL;
@@ -396,7 +410,7 @@ void unity_gtk_menu_section_print(UnityGtkMenuSection *section, guint indent)
 	{
 		g_print("%s%u (%s *) %p\n",
 		        space,
-		        section->section_index,
+		        unity_gtk_menu_section_get_index(section),
 		        G_OBJECT_CLASS_NAME(G_OBJECT_GET_CLASS(section)),
 		        section);
 
@@ -40,6 +40,19 @@ G_DEFINE_TYPE(UnityGtkMenuShell, unity_gtk_menu_shell, G_TYPE_MENU_MODEL);
 
 static gboolean unity_gtk_menu_shell_debug;
 
+enum
+{
+	UNITY_GTK_MENU_SHELL_DIRTY_ITEM    = 1 << 0,
+	UNITY_GTK_MENU_SHELL_DIRTY_ENABLED = 1 << 1,
+	UNITY_GTK_MENU_SHELL_DIRTY_STATE   = 1 << 2,
+};
+
+typedef struct
+{
+	guint section_index;
+	guint position;
+} UnityGtkMenuShellPosition;
+
 static gint g_uintcmp(gconstpointer a, gconstpointer b, gpointer user_data)
 {
 	return GPOINTER_TO_INT(a) - GPOINTER_TO_INT(b);
@@ -77,6 +90,11 @@ static GSequenceIter *g_sequence_search_inf_uint(GSequence *sequence, guint i)
 	return !g_sequence_iter_is_end(iter) && g_sequence_get_uint(iter) <= i ? iter : NULL;
 }
 
+static gpointer g_sequence_get_at_pos(GSequence *sequence, gint pos)
+{
+	return g_sequence_get(g_sequence_get_iter_at_pos(sequence, pos));
+}
+
 static gboolean gtk_menu_item_handle_idle_activate(gpointer user_data)
 {
 	g_return_val_if_fail(GTK_IS_MENU_ITEM(user_data), G_SOURCE_REMOVE);
@@ -114,7 +132,24 @@ static GPtrArray *unity_gtk_menu_shell_get_items(UnityGtkMenuShell *shell)
 	return shell->items;
 }
 
-static GPtrArray *unity_gtk_menu_shell_get_sections(UnityGtkMenuShell *shell)
+static void unity_gtk_menu_shell_free_section(gpointer data)
+{
+	UnityGtkMenuSection *section = data;
+
+	/* Exported sections may outlive their node, so forget it before dropping our ref. */
+	section->section_iter = NULL;
+	g_object_unref(section);
+}
+
+static GSequenceIter *unity_gtk_menu_shell_insert_section(GSequenceIter *before,
+                                                          UnityGtkMenuSection *section)
+{
+	section->section_iter = g_sequence_insert_before(before, section);
+
+	return section->section_iter;
+}
+
+static GSequence *unity_gtk_menu_shell_get_sections(UnityGtkMenuShell *shell)
 {
 	g_return_val_if_fail(UNITY_GTK_IS_MENU_SHELL(shell), NULL);
 
@@ -124,10 +159,16 @@ static GPtrArray *unity_gtk_menu_shell_get_sections(UnityGtkMenuShell *shell)
 		guint n                      = g_sequence_get_length(separator_indices);
 		guint i;
 
-		shell->sections = g_ptr_array_new_full(n + 1, g_object_unref);
+		/*
+		 * Sections are kept in a GSequence so that a section's index is the
+		 * position of its own node, and inserting or removing a section does
+		 * not renumber the ones after it.
+		 */
+		shell->sections = g_sequence_new(unity_gtk_menu_shell_free_section);
 
 		for (i = 0; i <= n; i++)
-			g_ptr_array_add(shell->sections, unity_gtk_menu_section_new(shell, i));
+			unity_gtk_menu_shell_insert_section(g_sequence_get_end_iter(shell->sections),
+			                                    unity_gtk_menu_section_new(shell));
 	}
 
 	return shell->sections;
@@ -171,7 +212,7 @@ static void unity_gtk_menu_shell_show_item(UnityGtkMenuShell *shell, UnityGtkMen
 
 		if (separator_indices != NULL)
 		{
-			GPtrArray *sections = shell->sections;
+			GSequence *sections = shell->sections;
 			GSequenceIter *separator_iter =
 			    g_sequence_search_inf_uint(separator_indices, item_index);
 			guint section_index =
@@ -192,27 +233,22 @@ static void unity_gtk_menu_shell_show_item(UnityGtkMenuShell *shell, UnityGtkMen
 					if (sections != NULL)
 					{
 						UnityGtkMenuSection *section =
-						    g_ptr_array_index(sections, section_index);
+						    g_sequence_get_at_pos(sections, section_index);
 						GSequenceIter *section_iter =
 						    unity_gtk_menu_section_get_begin_iter(section);
 						guint position =
 						    g_sequence_iter_get_position(insert_iter) -
 						    g_sequence_iter_get_position(section_iter);
 						UnityGtkMenuSection *new_section =
-						    unity_gtk_menu_section_new(shell,
-						                               section_index + 1);
-						guint removed = g_menu_model_get_n_items(
-						    G_MENU_MODEL(new_section));
-						guint i;
+						    unity_gtk_menu_section_new(shell);
+						guint removed;
 
-						g_ptr_array_insert(sections,
-						                   section_index + 1,
-						                   new_section);
+						unity_gtk_menu_shell_insert_section(
+						    g_sequence_iter_next(section->section_iter),
+						    new_section);
 
-						for (i = section_index + 2; i < sections->len; i++)
-							UNITY_GTK_MENU_SECTION(
-							    g_ptr_array_index(sections, i))
-							    ->section_index = i;
+						removed =
+						    g_menu_model_get_n_items(G_MENU_MODEL(new_section));
 
 						if (removed)
 							g_menu_model_items_changed(G_MENU_MODEL(
@@ -232,7 +268,7 @@ static void unity_gtk_menu_shell_show_item(UnityGtkMenuShell *shell, UnityGtkMen
 					if (sections != NULL)
 					{
 						UnityGtkMenuSection *section =
-						    g_ptr_array_index(sections, section_index);
+						    g_sequence_get_at_pos(sections, section_index);
 						GSequenceIter *section_iter =
 						    unity_gtk_menu_section_get_begin_iter(section);
 						guint position =
@@ -291,21 +327,21 @@ static void unity_gtk_menu_shell_hide_item(UnityGtkMenuShell *shell, UnityGtkMen
 
 				if (separator_iter != NULL)
 				{
-					GPtrArray *sections = shell->sections;
+					GSequence *sections = shell->sections;
 					guint section_index =
 					    g_sequence_iter_get_position(separator_iter);
 
 					if (shell->sections != NULL)
 					{
 						UnityGtkMenuSection *section =
-						    g_ptr_array_index(sections, section_index);
+						    g_sequence_get_at_pos(sections, section_index);
 						UnityGtkMenuSection *next_section =
-						    g_ptr_array_index(sections, section_index + 1);
+						    g_sequence_get(g_sequence_iter_next(
+						        section->section_iter));
 						guint position =
 						    g_menu_model_get_n_items(G_MENU_MODEL(section));
 						guint added = g_menu_model_get_n_items(
 						    G_MENU_MODEL(next_section));
-						guint i;
 
 						g_sequence_remove(separator_iter);
 
@@ -326,13 +362,7 @@ static void unity_gtk_menu_shell_hide_item(UnityGtkMenuShell *shell, UnityGtkMen
 							                           0,
 							                           added);
 
-						g_ptr_array_remove_index(sections,
-						                         section_index + 1);
-
-						for (i = section_index + 1; i < sections->len; i++)
-							UNITY_GTK_MENU_SECTION(
-							    g_ptr_array_index(sections, i))
-							    ->section_index = i;
+						g_sequence_remove(next_section->section_iter);
 					}
 					else
 					{
@@ -358,7 +388,7 @@ static void unity_gtk_menu_shell_hide_item(UnityGtkMenuShell *shell, UnityGtkMen
 			{
 				if (visible_iter != NULL)
 				{
-					GPtrArray *sections = shell->sections;
+					GSequence *sections = shell->sections;
 					GSequenceIter *separator_iter =
 					    g_sequence_search_inf_uint(separator_indices,
 					                               item_index);
@@ -370,7 +400,7 @@ static void unity_gtk_menu_shell_hide_item(UnityGtkMenuShell *shell, UnityGtkMen
 					if (shell->sections != NULL)
 					{
 						UnityGtkMenuSection *section =
-						    g_ptr_array_index(sections, section_index);
+						    g_sequence_get_at_pos(sections, section_index);
 						GSequenceIter *section_iter =
 						    unity_gtk_menu_section_get_begin_iter(section);
 						guint position =
@@ -398,13 +428,15 @@ static void unity_gtk_menu_shell_hide_item(UnityGtkMenuShell *shell, UnityGtkMen
 	}
 }
 
-static void unity_gtk_menu_shell_update_item(UnityGtkMenuShell *shell, UnityGtkMenuItem *item)
+static gboolean unity_gtk_menu_shell_get_item_position(UnityGtkMenuShell *shell,
+                                                       UnityGtkMenuItem *item,
+                                                       guint *section_index, guint *position)
 {
 	GSequence *visible_indices;
 	GSequenceIter *visible_iter;
 
-	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
-	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+	g_return_val_if_fail(UNITY_GTK_IS_MENU_SHELL(shell), FALSE);
+	g_return_val_if_fail(UNITY_GTK_IS_MENU_ITEM(item), FALSE);
 	g_warn_if_fail(item->parent_shell == shell);
 
 	visible_indices = unity_gtk_menu_shell_get_visible_indices(shell);
@@ -414,53 +446,28 @@ static void unity_gtk_menu_shell_update_item(UnityGtkMenuShell *shell, UnityGtkM
 	{
 		GSequence *separator_indices;
 		GSequenceIter *separator_iter;
-		guint section_index;
-		GPtrArray *sections;
+		GSequence *sections;
 		UnityGtkMenuSection *section;
 		GSequenceIter *section_iter;
-		guint position;
 
 		separator_indices = unity_gtk_menu_shell_get_separator_indices(shell);
 		separator_iter    = g_sequence_search_inf_uint(separator_indices, item->item_index);
-		section_index =
+		*section_index =
 		    separator_iter == NULL ? 0 : g_sequence_iter_get_position(separator_iter) + 1;
 		sections     = unity_gtk_menu_shell_get_sections(shell);
-		section      = g_ptr_array_index(sections, section_index);
+		section      = g_sequence_get_at_pos(sections, *section_index);
 		section_iter = unity_gtk_menu_section_get_begin_iter(section);
-		position     = g_sequence_iter_get_position(visible_iter) -
-		           g_sequence_iter_get_position(section_iter);
+		*position    = g_sequence_iter_get_position(visible_iter) -
+		            g_sequence_iter_get_position(section_iter);
 
-		g_menu_model_items_changed(G_MENU_MODEL(section), position, 1, 1);
+		return TRUE;
 	}
-}
-
-static void unity_gtk_menu_shell_handle_item_visible(UnityGtkMenuShell *shell,
-                                                     UnityGtkMenuItem *item)
-{
-	GSequence *visible_indices;
-
-	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
-	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
-	g_warn_if_fail(item->parent_shell == shell);
-
-	visible_indices = shell->visible_indices;
 
-	if (visible_indices != NULL)
-	{
-		GSequenceIter *visible_iter =
-		    g_sequence_lookup_uint(visible_indices, item->item_index);
-		gboolean was_visible = visible_iter != NULL;
-		gboolean is_visible  = unity_gtk_menu_item_is_visible(item);
-
-		if (!was_visible && is_visible)
-			unity_gtk_menu_shell_show_item(shell, item);
-		else if (was_visible && !is_visible)
-			unity_gtk_menu_shell_hide_item(shell, item);
-	}
+	return FALSE;
 }
 
-static void unity_gtk_menu_shell_handle_item_sensitive(UnityGtkMenuShell *shell,
-                                                       UnityGtkMenuItem *item)
+static void unity_gtk_menu_shell_update_item_enabled(UnityGtkMenuShell *shell,
+                                                     UnityGtkMenuItem *item)
 {
 	GActionGroup *action_group;
 	UnityGtkAction *action;
@@ -480,32 +487,8 @@ static void unity_gtk_menu_shell_handle_item_sensitive(UnityGtkMenuShell *shell,
 	}
 }
 
-static void unity_gtk_menu_shell_handle_item_label(UnityGtkMenuShell *shell, UnityGtkMenuItem *item)
-{
-	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
-	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
-	g_warn_if_fail(item->parent_shell == shell);
-
-	g_free(item->label_label);
-	item->label_label = NULL;
-
-	unity_gtk_menu_shell_update_item(shell, item);
-}
-
-static void unity_gtk_menu_shell_handle_item_use_underline(UnityGtkMenuShell *shell,
-                                                           UnityGtkMenuItem *item)
-{
-	unity_gtk_menu_shell_handle_item_label(shell, item);
-}
-
-static void unity_gtk_menu_shell_handle_item_accel_path(UnityGtkMenuShell *shell,
-                                                        UnityGtkMenuItem *item)
-{
-	unity_gtk_menu_shell_update_item(shell, item);
-}
-
-static void unity_gtk_menu_shell_handle_item_active(UnityGtkMenuShell *shell,
-                                                    UnityGtkMenuItem *item)
+static void unity_gtk_menu_shell_update_item_state(UnityGtkMenuShell *shell,
+                                                   UnityGtkMenuItem *item)
 {
 	GActionGroup *action_group;
 	UnityGtkAction *action;
@@ -554,6 +537,227 @@ static void unity_gtk_menu_shell_handle_item_active(UnityGtkMenuShell *shell,
 	}
 }
 
+static gint unity_gtk_menu_shell_position_compare(gconstpointer a, gconstpointer b)
+{
+	const UnityGtkMenuShellPosition *p = a;
+	const UnityGtkMenuShellPosition *q = b;
+
+	if (p->section_index != q->section_index)
+		return p->section_index < q->section_index ? -1 : 1;
+
+	return p->position < q->position ? -1 : p->position > q->position;
+}
+
+static gboolean unity_gtk_menu_shell_handle_flush_idle(gpointer user_data)
+{
+	UnityGtkMenuShell *shell;
+	GHashTable *dirty_items;
+	GHashTable *updated_actions;
+	GArray *positions;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	guint i;
+
+	g_return_val_if_fail(UNITY_GTK_IS_MENU_SHELL(user_data), G_SOURCE_REMOVE);
+
+	shell                = UNITY_GTK_MENU_SHELL(user_data);
+	dirty_items          = shell->dirty_items;
+	shell->dirty_items   = NULL;
+	shell->flush_idle_id = 0;
+
+	if (dirty_items == NULL)
+		return G_SOURCE_REMOVE;
+
+	updated_actions = g_hash_table_new(g_direct_hash, g_direct_equal);
+	positions       = g_array_new(FALSE, FALSE, sizeof(UnityGtkMenuShellPosition));
+
+	g_hash_table_iter_init(&iter, dirty_items);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		UnityGtkMenuItem *item = key;
+		guint flags            = GPOINTER_TO_UINT(value);
+
+		/* The item may have been removed from the shell after it was marked. */
+		if (shell->items == NULL || item->item_index >= shell->items->len ||
+		    g_ptr_array_index(shell->items, item->item_index) != item)
+			continue;
+
+		if (flags & UNITY_GTK_MENU_SHELL_DIRTY_ENABLED)
+			unity_gtk_menu_shell_update_item_enabled(shell, item);
+
+		/* Radio items share one action, so its state is computed once. */
+		if (flags & UNITY_GTK_MENU_SHELL_DIRTY_STATE && item->action != NULL &&
+		    g_hash_table_add(updated_actions, item->action))
+			unity_gtk_menu_shell_update_item_state(shell, item);
+
+		if (flags & UNITY_GTK_MENU_SHELL_DIRTY_ITEM)
+		{
+			UnityGtkMenuShellPosition position;
+
+			/* Exporters refetch the item, so it must not see a stale table. */
+			unity_gtk_menu_item_invalidate_attributes(item);
+
+			if (unity_gtk_menu_shell_get_item_position(shell,
+			                                           item,
+			                                           &position.section_index,
+			                                           &position.position))
+				g_array_append_val(positions, position);
+		}
+	}
+
+	g_array_sort(positions, unity_gtk_menu_shell_position_compare);
+
+	/* Emit one items-changed per run of adjacent changed items. */
+	for (i = 0; i < positions->len;)
+	{
+		UnityGtkMenuShellPosition *first =
+		    &g_array_index(positions, UnityGtkMenuShellPosition, i);
+		UnityGtkMenuSection *section;
+		guint n = 1;
+
+		while (i + n < positions->len)
+		{
+			UnityGtkMenuShellPosition *next =
+			    &g_array_index(positions, UnityGtkMenuShellPosition, i + n);
+
+			if (next->section_index != first->section_index ||
+			    next->position != first->position + n)
+				break;
+
+			n++;
+		}
+
+		section = g_sequence_get_at_pos(unity_gtk_menu_shell_get_sections(shell),
+		                                first->section_index);
+		g_menu_model_items_changed(G_MENU_MODEL(section), first->position, n, n);
+
+		i += n;
+	}
+
+	g_array_free(positions, TRUE);
+	g_hash_table_unref(updated_actions);
+	g_hash_table_unref(dirty_items);
+
+	return G_SOURCE_REMOVE;
+}
+
+/*
+ * Notifications that only change an item's attributes, enabled flag or
+ * state are collected per shell and flushed together from an idle, so a
+ * burst of changes results in merged items-changed ranges and a single
+ * action group update.
+ */
+static void unity_gtk_menu_shell_mark_item_dirty(UnityGtkMenuShell *shell,
+                                                 UnityGtkMenuItem *item, guint flags)
+{
+	gpointer old_flags;
+
+	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+	g_warn_if_fail(item->parent_shell == shell);
+
+	if (shell->dirty_items == NULL)
+		shell->dirty_items =
+		    g_hash_table_new_full(g_direct_hash, g_direct_equal, g_object_unref, NULL);
+	else if (g_hash_table_lookup_extended(shell->dirty_items, item, NULL, &old_flags))
+		flags |= GPOINTER_TO_UINT(old_flags);
+
+	g_hash_table_insert(shell->dirty_items, g_object_ref(item), GUINT_TO_POINTER(flags));
+
+	if (shell->flush_idle_id == 0)
+		shell->flush_idle_id =
+		    g_idle_add(unity_gtk_menu_shell_handle_flush_idle, shell);
+}
+
+static void unity_gtk_menu_shell_cancel_flush(UnityGtkMenuShell *shell)
+{
+	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
+
+	if (shell->flush_idle_id != 0)
+	{
+		g_source_remove(shell->flush_idle_id);
+		shell->flush_idle_id = 0;
+	}
+
+	if (shell->dirty_items != NULL)
+	{
+		g_hash_table_unref(shell->dirty_items);
+		shell->dirty_items = NULL;
+	}
+}
+
+static void unity_gtk_menu_shell_handle_item_visible(UnityGtkMenuShell *shell,
+                                                     UnityGtkMenuItem *item)
+{
+	GSequence *visible_indices;
+
+	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+	g_warn_if_fail(item->parent_shell == shell);
+
+	visible_indices = shell->visible_indices;
+
+	if (visible_indices != NULL)
+	{
+		GSequenceIter *visible_iter =
+		    g_sequence_lookup_uint(visible_indices, item->item_index);
+		gboolean was_visible = visible_iter != NULL;
+		gboolean is_visible  = unity_gtk_menu_item_is_visible(item);
+
+		if (!was_visible && is_visible)
+			unity_gtk_menu_shell_show_item(shell, item);
+		else if (was_visible && !is_visible)
+			unity_gtk_menu_shell_hide_item(shell, item);
+	}
+}
+
+static void unity_gtk_menu_shell_handle_item_sensitive(UnityGtkMenuShell *shell,
+                                                       UnityGtkMenuItem *item)
+{
+	unity_gtk_menu_shell_mark_item_dirty(shell, item, UNITY_GTK_MENU_SHELL_DIRTY_ENABLED);
+}
+
+static void unity_gtk_menu_shell_handle_item_label(UnityGtkMenuShell *shell, UnityGtkMenuItem *item)
+{
+	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
+	g_return_if_fail(UNITY_GTK_IS_MENU_ITEM(item));
+	g_warn_if_fail(item->parent_shell == shell);
+
+	g_free(item->label_label);
+	item->label_label = NULL;
+
+	unity_gtk_menu_item_invalidate_attributes(item);
+	unity_gtk_menu_shell_mark_item_dirty(shell, item, UNITY_GTK_MENU_SHELL_DIRTY_ITEM);
+}
+
+static void unity_gtk_menu_shell_handle_item_use_underline(UnityGtkMenuShell *shell,
+                                                           UnityGtkMenuItem *item)
+{
+	unity_gtk_menu_shell_handle_item_label(shell, item);
+}
+
+static void unity_gtk_menu_shell_handle_item_accel_path(UnityGtkMenuShell *shell,
+                                                        UnityGtkMenuItem *item)
+{
+	unity_gtk_menu_item_invalidate_attributes(item);
+	unity_gtk_menu_shell_mark_item_dirty(shell, item, UNITY_GTK_MENU_SHELL_DIRTY_ITEM);
+}
+
+static void unity_gtk_menu_shell_handle_item_attributes(UnityGtkMenuShell *shell,
+                                                        UnityGtkMenuItem *item)
+{
+	/* The icon and radio target are only exported through the attributes. */
+	unity_gtk_menu_item_invalidate_attributes(item);
+	unity_gtk_menu_shell_mark_item_dirty(shell, item, UNITY_GTK_MENU_SHELL_DIRTY_ITEM);
+}
+
+static void unity_gtk_menu_shell_handle_item_active(UnityGtkMenuShell *shell,
+                                                    UnityGtkMenuItem *item)
+{
+	unity_gtk_menu_shell_mark_item_dirty(shell, item, UNITY_GTK_MENU_SHELL_DIRTY_STATE);
+}
+
 static void unity_gtk_menu_shell_handle_item_parent(UnityGtkMenuShell *shell,
                                                     UnityGtkMenuItem *item)
 {
@@ -649,8 +853,8 @@ static void unity_gtk_menu_shell_handle_item_submenu(UnityGtkMenuShell *shell,
 			    separator_iter == NULL
 			        ? 0
 			        : g_sequence_iter_get_position(separator_iter) + 1;
-			GPtrArray *sections          = unity_gtk_menu_shell_get_sections(shell);
-			UnityGtkMenuSection *section = g_ptr_array_index(sections, section_index);
+			GSequence *sections          = unity_gtk_menu_shell_get_sections(shell);
+			UnityGtkMenuSection *section = g_sequence_get_at_pos(sections, section_index);
 			GSequenceIter *section_iter =
 			    unity_gtk_menu_section_get_begin_iter(section);
 			GSequenceIter *visible_iter =
@@ -665,6 +869,7 @@ static void unity_gtk_menu_shell_handle_item_submenu(UnityGtkMenuShell *shell,
 			}
 
 			item->child_shell_valid = FALSE;
+			unity_gtk_menu_item_invalidate_attributes(item);
 
 			g_menu_model_items_changed(G_MENU_MODEL(section), position, 1, 1);
 		}
@@ -777,46 +982,53 @@ static void unity_gtk_menu_shell_handle_settings_notify(GObject *object, GParamS
 
 static void unity_gtk_menu_shell_clear_menu_shell(UnityGtkMenuShell *shell);
 
+static void unity_gtk_menu_shell_free_items(UnityGtkMenuShell *shell)
+{
+	GPtrArray *items             = shell->items;
+	GSequence *sections          = shell->sections;
+	GSequence *visible_indices   = shell->visible_indices;
+	GSequence *separator_indices = shell->separator_indices;
+
+	unity_gtk_menu_shell_cancel_flush(shell);
+
+	if (separator_indices != NULL)
+	{
+		shell->separator_indices = NULL;
+		g_sequence_free(separator_indices);
+	}
+
+	if (visible_indices != NULL)
+	{
+		shell->visible_indices = NULL;
+		g_sequence_free(visible_indices);
+	}
+
+	if (sections != NULL)
+	{
+		shell->sections = NULL;
+		g_sequence_free(sections);
+	}
+
+	if (items != NULL)
+	{
+		shell->items = NULL;
+		g_ptr_array_unref(items);
+	}
+}
+
 static void unity_gtk_menu_shell_set_menu_shell(UnityGtkMenuShell *shell, GtkMenuShell *menu_shell)
 {
 	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(shell));
 
 	if (menu_shell != shell->menu_shell)
 	{
-		GPtrArray *items             = shell->items;
-		GPtrArray *sections          = shell->sections;
-		GSequence *visible_indices   = shell->visible_indices;
-		GSequence *separator_indices = shell->separator_indices;
-
 		if (shell->action_group != NULL)
 			unity_gtk_action_group_disconnect_shell(shell->action_group, shell);
 
 		if (shell->menu_shell != NULL)
 			g_signal_handlers_disconnect_by_data(shell->menu_shell, shell);
 
-		if (separator_indices != NULL)
-		{
-			shell->separator_indices = NULL;
-			g_sequence_free(separator_indices);
-		}
-
-		if (visible_indices != NULL)
-		{
-			shell->visible_indices = NULL;
-			g_sequence_free(visible_indices);
-		}
-
-		if (sections != NULL)
-		{
-			shell->sections = NULL;
-			g_ptr_array_unref(sections);
-		}
-
-		if (items != NULL)
-		{
-			shell->items = NULL;
-			g_ptr_array_unref(items);
-		}
+		unity_gtk_menu_shell_free_items(shell);
 
 		if (shell->menu_shell != NULL)
 			g_object_steal_qdata(G_OBJECT(shell->menu_shell), menu_shell_quark());
@@ -857,6 +1069,7 @@ static void unity_gtk_menu_shell_dispose(GObject *object)
 	settings = gtk_settings_get_default();
 
 	unity_gtk_menu_shell_set_menu_shell(shell, NULL);
+	unity_gtk_menu_shell_cancel_flush(shell);
 
 	if (settings != NULL)
 		g_signal_handlers_disconnect_by_data(settings, shell);
@@ -875,7 +1088,7 @@ static gint unity_gtk_menu_shell_get_n_items(GMenuModel *model)
 {
 	g_return_val_if_fail(UNITY_GTK_IS_MENU_SHELL(model), 0);
 
-	return unity_gtk_menu_shell_get_sections(UNITY_GTK_MENU_SHELL(model))->len;
+	return g_sequence_get_length(unity_gtk_menu_shell_get_sections(UNITY_GTK_MENU_SHELL(model)));
 }
 
 static void unity_gtk_menu_shell_get_item_attributes(GMenuModel *model, gint item_index,
@@ -893,7 +1106,7 @@ static void unity_gtk_menu_shell_get_item_links(GMenuModel *model, gint item_ind
                                                 GHashTable **links)
 {
 	UnityGtkMenuShell *shell;
-	GPtrArray *sections;
+	GSequence *sections;
 	UnityGtkMenuSection *section;
 
 	g_return_if_fail(UNITY_GTK_IS_MENU_SHELL(model));
@@ -902,7 +1115,7 @@ static void unity_gtk_menu_shell_get_item_links(GMenuModel *model, gint item_ind
 
 	shell    = UNITY_GTK_MENU_SHELL(model);
 	sections = unity_gtk_menu_shell_get_sections(shell);
-	section  = g_ptr_array_index(sections, item_index);
+	section  = g_sequence_get_at_pos(sections, item_index);
 
 	*links = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_object_unref);
 	g_hash_table_insert(*links, G_MENU_LINK_SECTION, g_object_ref(section));
@@ -1039,6 +1252,8 @@ void unity_gtk_menu_shell_handle_item_notify(UnityGtkMenuShell *shell, UnityGtkM
 	static const char *active_name;
 	static const char *parent_name;
 	static const char *submenu_name;
+	static const char *image_name;
+	static const char *draw_as_radio_name;
 
 	const char *name;
 
@@ -1061,6 +1276,10 @@ void unity_gtk_menu_shell_handle_item_notify(UnityGtkMenuShell *shell, UnityGtkM
 		parent_name = g_intern_static_string("parent");
 	if (G_UNLIKELY(submenu_name == NULL))
 		submenu_name = g_intern_static_string("submenu");
+	if (G_UNLIKELY(image_name == NULL))
+		image_name = g_intern_static_string("image");
+	if (G_UNLIKELY(draw_as_radio_name == NULL))
+		draw_as_radio_name = g_intern_static_string("draw-as-radio");
 
 	name = g_intern_string(property);
 
@@ -1090,6 +1309,8 @@ void unity_gtk_menu_shell_handle_item_notify(UnityGtkMenuShell *shell, UnityGtkM
 		unity_gtk_menu_shell_handle_item_parent(shell, item);
 	else if (name == submenu_name)
 		unity_gtk_menu_shell_handle_item_submenu(shell, item);
+	else if (name == image_name || name == draw_as_radio_name)
+		unity_gtk_menu_shell_handle_item_attributes(shell, item);
 }
 
 void unity_gtk_menu_shell_activate_item(UnityGtkMenuShell *shell, UnityGtkMenuItem *item)
@@ -1158,11 +1379,13 @@ void unity_gtk_menu_shell_print(UnityGtkMenuShell *shell, guint indent)
 
 		if (shell->sections != NULL)
 		{
-			guint i;
+			GSequenceIter *iter = g_sequence_get_begin_iter(shell->sections);
 
-			for (i = 0; i < shell->sections->len; i++)
-				unity_gtk_menu_section_print(g_ptr_array_index(shell->sections, i),
-				                             indent + 2);
+			while (!g_sequence_iter_is_end(iter))
+			{
+				unity_gtk_menu_section_print(g_sequence_get(iter), indent + 2);
+				iter = g_sequence_iter_next(iter);
+			}
 		}
 
 		if (shell->visible_indices != NULL)
@@ -200,6 +200,93 @@ JNIEXPORT jlong JNICALL Java_com_jarego_jayatana_basic_GlobalMenu_getWindowXID(J
 	return (long)drawable;
 }
 
+/**
+ * Windows waiting for registration, sent by one RegisterWindows call
+ */
+static GVariantBuilder *jayatana_pending_windows = NULL;
+static guint jayatana_pending_source             = 0;
+
+/**
+ * Errors meaning the bulk call never reached a registrar with bulk API, e.g. when
+ * another registrar owns com.canonical.AppMenu.Registrar
+ */
+static bool jayatana_bulk_call_not_delivered(const GError *error)
+{
+	return g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD) ||
+	       g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT) ||
+	       g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_INTERFACE) ||
+	       g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN) ||
+	       g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_NAME_HAS_NO_OWNER);
+}
+
+/**
+ * Fall back to one RegisterWindow per window when the bulk call was not delivered.
+ * Other errors may come after the windows were registered, so they are not retried.
+ */
+static void jayatana_on_windows_registered(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GVariant) windows = (GVariant *)user_data;
+	g_autoptr(GError) error     = NULL;
+	g_autoptr(GVariant) ret =
+	    g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+	if (ret != NULL)
+		return;
+	if (!jayatana_bulk_call_not_delivered(error))
+	{
+		g_warning("Cannot register windows: %s", error->message);
+		return;
+	}
+	GVariantIter iter;
+	GVariant *window;
+	g_variant_iter_init(&iter, windows);
+	while ((window = g_variant_iter_next_value(&iter)) != NULL)
+	{
+		g_dbus_connection_call(G_DBUS_CONNECTION(source),
+		                       "com.canonical.AppMenu.Registrar",
+		                       "/com/canonical/AppMenu/Registrar",
+		                       "com.canonical.AppMenu.Registrar",
+		                       "RegisterWindow",
+		                       window,
+		                       NULL,
+		                       G_DBUS_CALL_FLAGS_NONE,
+		                       -1,
+		                       NULL,
+		                       NULL,
+		                       NULL);
+		g_variant_unref(window);
+	}
+}
+
+/**
+ * Register all windows queued during this main loop iteration
+ */
+static gboolean jayatana_flush_pending_windows(gpointer user_data)
+{
+	GVariant *windows = g_variant_ref_sink(g_variant_builder_end(jayatana_pending_windows));
+	g_variant_builder_unref(jayatana_pending_windows);
+	jayatana_pending_windows = NULL;
+	jayatana_pending_source  = 0;
+	g_autoptr(GDBusConnection) connection = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	if (connection == NULL)
+	{
+		g_variant_unref(windows);
+		return G_SOURCE_REMOVE;
+	}
+	g_dbus_connection_call(connection,
+	                       "org.valapanel.AppMenu.Registrar",
+	                       "/org/valapanel/AppMenu/Registrar",
+	                       "org.valapanel.AppMenu.Registrar",
+	                       "RegisterWindows",
+	                       g_variant_new("(@a(uo))", windows),
+	                       NULL,
+	                       G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                       -1,
+	                       NULL,
+	                       jayatana_on_windows_registered,
+	                       windows);
+	return G_SOURCE_REMOVE;
+}
+
 /**
  * Notification of bus available for global menu
  */
@@ -229,16 +316,17 @@ void jayatana_on_registrar_available(GDBusConnection *connection, const char *na
 		                                  "com.canonical.AppMenu.Registrar",
 		                                  NULL,
 		                                  NULL);
-		globalmenu_window->dbBusProxyCallSync =
-		    g_dbus_proxy_call_sync(globalmenu_window->dbBusProxy,
-		                           "RegisterWindow",
-		                           g_variant_new("(uo)",
-		                                         (guint32)globalmenu_window->windowXID,
-		                                         globalmenu_window->windowXIDPath),
-		                           G_DBUS_CALL_FLAGS_NONE,
-		                           -1,
-		                           NULL,
-		                           NULL);
+		// queue registration, windows appearing together share one call
+		globalmenu_window->registerRequest =
+		    g_variant_ref_sink(g_variant_new("(uo)",
+		                                     (guint32)globalmenu_window->windowXID,
+		                                     globalmenu_window->windowXIDPath));
+		if (jayatana_pending_windows == NULL)
+			jayatana_pending_windows = g_variant_builder_new(G_VARIANT_TYPE("a(uo)"));
+		g_variant_builder_add_value(jayatana_pending_windows,
+		                            globalmenu_window->registerRequest);
+		if (jayatana_pending_source == 0)
+			jayatana_pending_source = g_idle_add(jayatana_flush_pending_windows, NULL);
 		jint register_state = globalmenu_window->registerState;
 		if (globalmenu_window->registerState == REGISTER_STATE_REFRESH)
 			globalmenu_window->registerState = REGISTER_STATE_INITIAL;
@@ -279,7 +367,7 @@ void jayatana_on_registrar_unavailable(GDBusConnection *connection, const char *
 			// free menus
 			g_object_unref(G_OBJECT(globalmenu_window->dbusMenuRoot));
 			g_object_unref(G_OBJECT(globalmenu_window->dbusMenuServer));
-			g_variant_unref(globalmenu_window->dbBusProxyCallSync);
+			g_variant_unref(globalmenu_window->registerRequest);
 			g_object_unref(G_OBJECT(globalmenu_window->dbBusProxy));
 			// free window path
 			g_free(globalmenu_window->windowXIDPath);
@@ -372,7 +460,7 @@ JNIEXPORT void JNICALL Java_com_jarego_jayatana_basic_GlobalMenu_refreshWatcher(
 				g_object_unref(G_OBJECT(globalmenu_window->dbusMenuRoot));
 				g_object_unref(G_OBJECT(globalmenu_window->dbusMenuServer));
 				// liberar bus
-				g_variant_unref(globalmenu_window->dbBusProxyCallSync);
+				g_variant_unref(globalmenu_window->registerRequest);
 				g_object_unref(G_OBJECT(globalmenu_window->dbBusProxy));
 				// liberar ruta de ventana
 				free(globalmenu_window->windowXIDPath);
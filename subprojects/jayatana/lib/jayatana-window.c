@@ -20,7 +20,7 @@ JAyatanaWindow *jayatana_window_copy(JAyatanaWindow *src)
 	ret->gdBusProxyRegistered = src->gdBusProxyRegistered;
 	ret->gBusWatcher          = src->gBusWatcher;
 	ret->dbBusProxy           = G_DBUS_PROXY(g_object_ref(src->dbBusProxy));
-	ret->dbBusProxyCallSync   = g_variant_ref(src->dbBusProxyCallSync);
+	ret->registerRequest      = g_variant_ref(src->registerRequest);
 
 	ret->dbusMenuServer = DBUSMENU_SERVER(g_object_ref(src->dbusMenuServer));
 	ret->dbusMenuRoot   = DBUSMENU_MENUITEM(g_object_ref(src->dbusMenuRoot));
@@ -36,7 +36,7 @@ void jayatana_window_free(JAyatanaWindow *window)
 	{
 		g_clear_pointer(&window->windowXIDPath, g_free);
 		g_clear_object(&window->dbBusProxy);
-		g_clear_pointer(&window->dbBusProxyCallSync, g_variant_unref);
+		g_clear_pointer(&window->registerRequest, g_variant_unref);
 		g_clear_object(&window->dbusMenuServer);
 		g_clear_object(&window->dbusMenuRoot);
 	}
@@ -22,7 +22,8 @@ typedef struct
 	bool gdBusProxyRegistered;
 	guint gBusWatcher;
 	GDBusProxy *dbBusProxy;
-	GVariant *dbBusProxyCallSync;
+	// (uo) arguments this window was queued with for RegisterWindows
+	GVariant *registerRequest;
 
 	DbusmenuServer *dbusMenuServer;
 	DbusmenuMenuitem *dbusMenuRoot;
@@ -0,0 +1,416 @@
+/*
+ * vala-panel-appmenu
+ * Copyright (C) 2018 Konstantin Pugin <ria.freelander@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Load test for appmenu-registrar. Starts it on a private bus, drives it with synthetic
+// clients and prints one JSON object per measurement on stdout.
+
+#include "registrar-dbusmenu.h"
+#include <glib/gstdio.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define PRIVATE_NAME "org.valapanel.AppMenu.Registrar"
+#define PRIVATE_OBJECT "/org/valapanel/AppMenu/Registrar"
+#define GET_MENUS_REPEAT 5
+
+static int n_clients = 16;
+static int n_windows = 64;
+static int n_lookups = 10000;
+static int n_samples = 8;
+
+static const GOptionEntry options[] = {
+	{ "clients", 'c', 0, G_OPTION_ARG_INT, &n_clients, "Number of synthetic clients", "N" },
+	{ "windows", 'w', 0, G_OPTION_ARG_INT, &n_windows, "Windows registered by each client", "M" },
+	{ "lookups", 'l', 0, G_OPTION_ARG_INT, &n_lookups, "GetMenuForWindow calls to time", "K" },
+	{ "samples", 's', 0, G_OPTION_ARG_INT, &n_samples, "Table sizes to time GetMenus at", "S" },
+	{ NULL }
+};
+
+typedef struct
+{
+	uint pending;
+	GError *error;
+} BenchBatch;
+
+static void bench_call_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	BenchBatch *batch = (BenchBatch *)user_data;
+	g_autoptr(GVariant) ret =
+	    g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+	                                  res,
+	                                  batch->error == NULL ? &batch->error : NULL);
+	batch->pending--;
+}
+
+static uint bench_window_id(int client, int window)
+{
+	return (uint)(client * n_windows + window + 1);
+}
+
+// Sends (Un)RegisterWindow for windows [first, last) of every client at once, and
+// returns seconds until all of them were answered
+static double bench_batch(GDBusConnection **clients, bool reg, int first, int last,
+                          GError **error)
+{
+	BenchBatch batch = { 0, NULL };
+	gint64 start     = g_get_monotonic_time();
+	for (int w = first; w < last; w++)
+		for (int c = 0; c < n_clients; c++)
+		{
+			uint window_id = bench_window_id(c, w);
+			g_autofree char *path = g_strdup_printf("/MenuBar/%u", window_id);
+			g_dbus_connection_call(clients[c],
+			                       DBUSMENU_REG_IFACE,
+			                       DBUSMENU_REG_OBJECT,
+			                       DBUSMENU_REG_IFACE,
+			                       reg ? "RegisterWindow" : "UnregisterWindow",
+			                       reg ? g_variant_new("(uo)", window_id, path)
+			                           : g_variant_new("(u)", window_id),
+			                       NULL,
+			                       G_DBUS_CALL_FLAGS_NO_AUTO_START,
+			                       -1,
+			                       NULL,
+			                       bench_call_done,
+			                       &batch);
+			batch.pending++;
+		}
+	while (batch.pending > 0)
+		g_main_context_iteration(NULL, true);
+	if (batch.error)
+		g_propagate_error(error, batch.error);
+	return (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+}
+
+// Sends one (Un)RegisterWindows with all windows of every client at once, and returns
+// seconds until all of them were answered
+static double bench_bulk(GDBusConnection **clients, bool reg, GError **error)
+{
+	BenchBatch batch = { 0, NULL };
+	gint64 start     = g_get_monotonic_time();
+	for (int c = 0; c < n_clients; c++)
+	{
+		GVariantBuilder windows;
+		g_variant_builder_init(&windows, reg ? G_VARIANT_TYPE("a(uo)") : G_VARIANT_TYPE("au"));
+		for (int w = 0; w < n_windows; w++)
+		{
+			uint window_id = bench_window_id(c, w);
+			if (reg)
+			{
+				g_autofree char *path = g_strdup_printf("/MenuBar/%u", window_id);
+				g_variant_builder_add(&windows, "(uo)", window_id, path);
+			}
+			else
+				g_variant_builder_add(&windows, "u", window_id);
+		}
+		g_dbus_connection_call(clients[c],
+		                       PRIVATE_NAME,
+		                       PRIVATE_OBJECT,
+		                       PRIVATE_NAME,
+		                       reg ? "RegisterWindows" : "UnregisterWindows",
+		                       g_variant_new(reg ? "(a(uo))" : "(au)", &windows),
+		                       NULL,
+		                       G_DBUS_CALL_FLAGS_NO_AUTO_START,
+		                       -1,
+		                       NULL,
+		                       bench_call_done,
+		                       &batch);
+		batch.pending++;
+	}
+	while (batch.pending > 0)
+		g_main_context_iteration(NULL, true);
+	if (batch.error)
+		g_propagate_error(error, batch.error);
+	return (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+}
+
+static void bench_print_throughput(const char *name, uint calls, double seconds)
+{
+	g_print("{\"benchmark\": \"%s\", \"clients\": %d, \"windows\": %d, \"calls\": %u, "
+	        "\"seconds\": %.6f, \"calls_per_second\": %.1f}\n",
+	        name,
+	        n_clients,
+	        n_windows,
+	        calls,
+	        seconds,
+	        calls / seconds);
+}
+
+// Returns number of windows in the table, or -1 on error
+static int bench_get_menus(GDBusConnection *connection, GError **error)
+{
+	gint64 elapsed = 0;
+	gsize size     = 0;
+	int count      = -1;
+	for (int i = 0; i < GET_MENUS_REPEAT; i++)
+	{
+		gint64 start            = g_get_monotonic_time();
+		g_autoptr(GVariant) ret = g_dbus_connection_call_sync(connection,
+		                                                      DBUSMENU_REG_IFACE,
+		                                                      DBUSMENU_REG_OBJECT,
+		                                                      DBUSMENU_REG_IFACE,
+		                                                      "GetMenus",
+		                                                      NULL,
+		                                                      G_VARIANT_TYPE("(a(uso))"),
+		                                                      G_DBUS_CALL_FLAGS_NO_AUTO_START,
+		                                                      -1,
+		                                                      NULL,
+		                                                      error);
+		if (ret == NULL)
+			return -1;
+		elapsed += g_get_monotonic_time() - start;
+		g_autoptr(GVariant) menus = g_variant_get_child_value(ret, 0);
+		count                     = (int)g_variant_n_children(menus);
+		size                      = g_variant_get_size(menus);
+	}
+	g_print("{\"benchmark\": \"get_menus\", \"table_size\": %d, \"reply_bytes\": %" G_GSIZE_FORMAT
+	        ", \"usec\": %.1f}\n",
+	        count,
+	        size,
+	        elapsed / (double)GET_MENUS_REPEAT);
+	return count;
+}
+
+static int bench_compare_latency(const void *a, const void *b)
+{
+	gint64 x = *(const gint64 *)a, y = *(const gint64 *)b;
+	return (x > y) - (x < y);
+}
+
+static bool bench_lookups(GDBusConnection **clients, GError **error)
+{
+	g_autofree gint64 *latency = g_new(gint64, n_lookups);
+	gint64 total               = 0;
+	for (int i = 0; i < n_lookups; i++)
+	{
+		uint window_id = bench_window_id(g_random_int_range(0, n_clients),
+		                                 g_random_int_range(0, n_windows));
+		gint64 start   = g_get_monotonic_time();
+		g_autoptr(GVariant) ret =
+		    g_dbus_connection_call_sync(clients[i % n_clients],
+		                                DBUSMENU_REG_IFACE,
+		                                DBUSMENU_REG_OBJECT,
+		                                DBUSMENU_REG_IFACE,
+		                                "GetMenuForWindow",
+		                                g_variant_new("(u)", window_id),
+		                                G_VARIANT_TYPE("(so)"),
+		                                G_DBUS_CALL_FLAGS_NO_AUTO_START,
+		                                -1,
+		                                NULL,
+		                                error);
+		if (ret == NULL)
+			return false;
+		latency[i] = g_get_monotonic_time() - start;
+		total += latency[i];
+	}
+	qsort(latency, n_lookups, sizeof(gint64), bench_compare_latency);
+	g_print("{\"benchmark\": \"get_menu_for_window\", \"calls\": %d, \"p50_usec\": %" G_GINT64_FORMAT
+	        ", \"p99_usec\": %" G_GINT64_FORMAT ", \"mean_usec\": %.1f, \"calls_per_second\": %.1f}\n",
+	        n_lookups,
+	        latency[n_lookups / 2],
+	        latency[(gint64)n_lookups * 99 / 100],
+	        total / (double)n_lookups,
+	        n_lookups * (double)G_USEC_PER_SEC / total);
+	return true;
+}
+
+static bool bench_wait_for_name(GDBusConnection *connection, const char *name)
+{
+	for (int i = 0; i < 500; i++)
+	{
+		g_autoptr(GVariant) ret = g_dbus_connection_call_sync(connection,
+		                                                      "org.freedesktop.DBus",
+		                                                      "/org/freedesktop/DBus",
+		                                                      "org.freedesktop.DBus",
+		                                                      "NameHasOwner",
+		                                                      g_variant_new("(s)", name),
+		                                                      G_VARIANT_TYPE("(b)"),
+		                                                      G_DBUS_CALL_FLAGS_NONE,
+		                                                      -1,
+		                                                      NULL,
+		                                                      NULL);
+		gboolean has_owner = false;
+		if (ret)
+			g_variant_get(ret, "(b)", &has_owner);
+		if (has_owner)
+			return true;
+		g_usleep(10000);
+	}
+	return false;
+}
+
+static bool bench_run(const char *address, GError **error)
+{
+	g_autofree GDBusConnection **clients = g_new0(GDBusConnection *, n_clients);
+	bool ok                              = false;
+	double seconds                       = 0;
+	for (int c = 0; c < n_clients; c++)
+	{
+		clients[c] = g_dbus_connection_new_for_address_sync(
+		    address,
+		    G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+		        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+		    NULL,
+		    NULL,
+		    error);
+		if (clients[c] == NULL)
+			goto out;
+	}
+	if (!bench_wait_for_name(clients[0], PRIVATE_NAME) ||
+	    !bench_wait_for_name(clients[0], DBUSMENU_REG_IFACE))
+	{
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, "Registrar did not appear on bus");
+		goto out;
+	}
+	// Keep service alive for the whole run
+	g_dbus_connection_call(clients[0],
+	                       PRIVATE_NAME,
+	                       PRIVATE_OBJECT,
+	                       PRIVATE_NAME,
+	                       "Reference",
+	                       NULL,
+	                       NULL,
+	                       G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                       -1,
+	                       NULL,
+	                       NULL,
+	                       NULL);
+
+	// Grow the table in steps, timing GetMenus at each size
+	int samples = CLAMP(n_samples, 1, n_windows);
+	for (int s = 0; s < samples; s++)
+	{
+		int first = n_windows * s / samples, last = n_windows * (s + 1) / samples;
+		seconds += bench_batch(clients, true, first, last, error);
+		if (*error)
+			goto out;
+		int count = bench_get_menus(clients[0], error);
+		if (count < 0)
+			goto out;
+		if (count != n_clients * last)
+		{
+			g_set_error(error,
+			            G_IO_ERROR,
+			            G_IO_ERROR_FAILED,
+			            "Registrar has %d windows, expected %d",
+			            count,
+			            n_clients * last);
+			goto out;
+		}
+	}
+	bench_print_throughput("register", n_clients * n_windows, seconds);
+	if (!bench_lookups(clients, error))
+		goto out;
+	seconds = bench_batch(clients, false, 0, n_windows, error);
+	if (*error)
+		goto out;
+	bench_print_throughput("unregister", n_clients * n_windows, seconds);
+	if (bench_get_menus(clients[0], error) != 0)
+		goto kept;
+
+	// Same windows again, one private bulk call per client
+	seconds = bench_bulk(clients, true, error);
+	if (*error)
+		goto out;
+	int count = bench_get_menus(clients[0], error);
+	if (count < 0)
+		goto out;
+	if (count != n_clients * n_windows)
+	{
+		g_set_error(error,
+		            G_IO_ERROR,
+		            G_IO_ERROR_FAILED,
+		            "Registrar has %d windows, expected %d",
+		            count,
+		            n_clients * n_windows);
+		goto out;
+	}
+	bench_print_throughput("register_windows", n_clients * n_windows, seconds);
+	seconds = bench_bulk(clients, false, error);
+	if (*error)
+		goto out;
+	bench_print_throughput("unregister_windows", n_clients * n_windows, seconds);
+	ok = bench_get_menus(clients[0], error) == 0;
+kept:
+	if (!ok && *error == NULL)
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Registrar kept unregistered windows");
+out:
+	for (int c = 0; c < n_clients; c++)
+		g_clear_object(&clients[c]);
+	return ok;
+}
+
+// Runtime dir of the spawned registrar holds only its snapshot
+static void bench_remove_runtime_dir(const char *path)
+{
+	const char *name;
+	g_autoptr(GDir) dir = g_dir_open(path, 0, NULL);
+	if (dir == NULL)
+		return;
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		g_autofree char *file = g_build_filename(path, name, NULL);
+		g_unlink(file);
+	}
+	g_rmdir(path);
+}
+
+int main(int argc, char *argv[])
+{
+	g_autoptr(GError) error            = NULL;
+	g_autoptr(GOptionContext) context = g_option_context_new("REGISTRAR - benchmark registrar");
+	g_option_context_add_main_entries(context, options, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error) || argc < 2)
+	{
+		g_printerr("%s\n", error ? error->message : "Path to appmenu-registrar is required");
+		return EXIT_FAILURE;
+	}
+	if (n_clients < 1 || n_windows < 1 || n_lookups < 1)
+	{
+		g_printerr("Counts must be positive\n");
+		return EXIT_FAILURE;
+	}
+
+	// Registrar must neither restore nor overwrite the snapshot of the user session
+	g_autofree char *runtime_dir = g_dir_make_tmp("appmenu-registrar-bench-XXXXXX", &error);
+	if (runtime_dir == NULL)
+	{
+		g_printerr("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_autoptr(GTestDBus) bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+	g_test_dbus_up(bus);
+	g_autoptr(GSubprocessLauncher) launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_NONE);
+	g_subprocess_launcher_setenv(launcher, "XDG_RUNTIME_DIR", runtime_dir, true);
+	g_autoptr(GSubprocess) registrar =
+	    g_subprocess_launcher_spawn(launcher, &error, argv[1], "--gapplication-service", NULL);
+	bool ok = registrar != NULL && bench_run(g_test_dbus_get_bus_address(bus), &error);
+	if (registrar)
+	{
+		g_subprocess_send_signal(registrar, SIGTERM);
+		g_subprocess_wait(registrar, NULL, NULL);
+	}
+	g_test_dbus_down(bus);
+	bench_remove_runtime_dir(runtime_dir);
+	if (!ok)
+	{
+		g_printerr("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -22,33 +22,54 @@
 
 extern const char *introspection_xml;
 
+// Changes kept for GetMenusSince, older clients get a full resync
+#define REGISTRAR_LOG_MAX 1024
+// Seconds to coalesce changes before the table is written to runtime dir
+#define REGISTRAR_SNAPSHOT_DELAY 1
+// Snapshot of each bus is kept in its own file, named by bus guid
+#define REGISTRAR_SNAPSHOT_FILE "appmenu-registrar-%s.snapshot"
+#define REGISTRAR_SNAPSHOT_TYPE "(sa(usot))"
+
 typedef struct
 {
-	char *bus_name;
-	char *object_path;
+	guint64 revision;
+	uint window_id;
+} RegistrarChange;
+
+// Replies are built once per registration and shared by all lookups. Strings point into them.
+typedef struct
+{
+	const char *bus_name;
+	const char *object_path;
+	GVariant *entry; // (uso) for GetMenus
+	GVariant *reply; // (so) for GetMenuForWindow
+	gint64 time;     // Registration time, seconds since Epoch
 } DBusAddress;
 
-DBusAddress *dbus_address_new(const char *bus_name, const char *object_path)
+DBusAddress *dbus_address_new(uint window_id, const char *bus_name, const char *object_path)
 {
-	DBusAddress *ret = (DBusAddress *)g_slice_alloc0(sizeof(DBusAddress));
-	ret->bus_name    = g_strdup(bus_name);
-	ret->object_path = g_strdup(object_path);
+	DBusAddress *ret = (DBusAddress *)g_slice_new(DBusAddress);
+	ret->entry = g_variant_ref_sink(g_variant_new("(uso)", window_id, bus_name, object_path));
+	ret->reply = g_variant_ref_sink(g_variant_new("(so)", bus_name, object_path));
+	g_variant_get(ret->reply, "(&s&o)", &ret->bus_name, &ret->object_path);
+	ret->time = g_get_real_time() / G_USEC_PER_SEC;
 	return ret;
 }
 
 DBusAddress *dbus_address_copy(const DBusAddress *src)
 {
 	DBusAddress *ret = (DBusAddress *)g_slice_new(DBusAddress);
-	ret->bus_name    = g_strdup(src->bus_name);
-	ret->object_path = g_strdup(src->object_path);
+	*ret             = *src;
+	g_variant_ref(ret->entry);
+	g_variant_ref(ret->reply);
 	return ret;
 }
 
 void dbus_address_free(void *obj)
 {
 	DBusAddress *addr = (DBusAddress *)obj;
-	g_free(addr->bus_name);
-	g_free(addr->object_path);
+	g_variant_unref(addr->entry);
+	g_variant_unref(addr->reply);
 	g_slice_free1(sizeof(DBusAddress), addr);
 }
 
@@ -58,7 +79,18 @@ struct _RegistrarDBusMenu
 {
 	GObject parent;
 	GHashTable *menus;
+	// Unique name of sender -> set of its window ids. All senders are watched by one
+	// NameOwnerChanged subscription, so windows of vanished clients are dropped.
+	GHashTable *senders;
+	// Revision of the last change, and the oldest revision the log can answer for
+	guint64 revision;
+	guint64 log_base;
+	GArray *log;
+	// Guid of the bus the snapshot belongs to, unique names are meaningless on other buses
+	char *bus_guid;
+	uint snapshot_source;
 	uint registered_object;
+	uint name_owner_subscription;
 };
 
 G_DEFINE_TYPE(RegistrarDBusMenu, registrar_dbus_menu, G_TYPE_OBJECT)
@@ -67,35 +99,322 @@ enum
 {
 	WINDOW_REGISTERED_SIGNAL,
 	WINDOW_UNREGISTERED_SIGNAL,
+	WINDOWS_CHANGED_SIGNAL,
 	NUM_SIGNALS
 };
 static uint registrar_dbus_menu_signals[NUM_SIGNALS] = { 0 };
 
+static char *registrar_dbus_menu_snapshot_path(RegistrarDBusMenu *self)
+{
+	g_autofree char *name = g_strdup_printf(REGISTRAR_SNAPSHOT_FILE, self->bus_guid);
+	return g_build_filename(g_get_user_runtime_dir(), name, NULL);
+}
+
+static gboolean registrar_dbus_menu_save_snapshot(gpointer user_data)
+{
+	RegistrarDBusMenu *self = REGISTRAR_DBUS_MENU(user_data);
+	g_autoptr(GError) err   = NULL;
+	GVariantBuilder bldr;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	self->snapshot_source = 0;
+	if (self->bus_guid == NULL)
+		return G_SOURCE_REMOVE;
+	g_variant_builder_init(&bldr, G_VARIANT_TYPE("a(usot)"));
+	g_hash_table_iter_init(&iter, self->menus);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		DBusAddress *addr = (DBusAddress *)value;
+		g_variant_builder_add(&bldr,
+		                      "(usot)",
+		                      GPOINTER_TO_UINT(key),
+		                      addr->bus_name,
+		                      addr->object_path,
+		                      (guint64)addr->time);
+	}
+	g_autoptr(GVariant) snapshot =
+	    g_variant_ref_sink(g_variant_new(REGISTRAR_SNAPSHOT_TYPE, self->bus_guid, &bldr));
+	g_autofree char *path = registrar_dbus_menu_snapshot_path(self);
+	if (!g_file_set_contents(path,
+	                         g_variant_get_data(snapshot),
+	                         (gssize)g_variant_get_size(snapshot),
+	                         &err))
+		g_warning("Cannot save registrar snapshot: %s", err->message);
+	return G_SOURCE_REMOVE;
+}
+
+static void registrar_dbus_menu_log_change(RegistrarDBusMenu *self, uint window_id)
+{
+	if (self->snapshot_source == 0)
+		self->snapshot_source = g_timeout_add_seconds(REGISTRAR_SNAPSHOT_DELAY,
+		                                              registrar_dbus_menu_save_snapshot,
+		                                              self);
+	RegistrarChange change = { ++self->revision, window_id };
+	g_array_append_val(self->log, change);
+	if (self->log->len <= REGISTRAR_LOG_MAX)
+		return;
+	uint drop      = self->log->len / 2;
+	self->log_base = g_array_index(self->log, RegistrarChange, drop - 1).revision;
+	g_array_remove_range(self->log, 0, drop);
+}
+
+static void registrar_dbus_menu_sender_remove_window(RegistrarDBusMenu *self, uint window_id)
+{
+	DBusAddress *addr =
+	    (DBusAddress *)g_hash_table_lookup(self->menus, GUINT_TO_POINTER(window_id));
+	if (addr == NULL)
+		return;
+	GHashTable *windows = (GHashTable *)g_hash_table_lookup(self->senders, addr->bus_name);
+	if (windows == NULL)
+		return;
+	g_hash_table_remove(windows, GUINT_TO_POINTER(window_id));
+	if (g_hash_table_size(windows) == 0)
+		g_hash_table_remove(self->senders, addr->bus_name);
+}
+
+static void registrar_dbus_menu_sender_add_window(RegistrarDBusMenu *self, uint window_id,
+                                                  const char *sender)
+{
+	GHashTable *windows = (GHashTable *)g_hash_table_lookup(self->senders, sender);
+	if (windows == NULL)
+	{
+		windows = g_hash_table_new(g_direct_hash, g_direct_equal);
+		g_hash_table_insert(self->senders, g_strdup(sender), windows);
+	}
+	g_hash_table_add(windows, GUINT_TO_POINTER(window_id));
+}
+
+static DBusAddress *registrar_dbus_menu_insert_window(RegistrarDBusMenu *self, uint window_id,
+                                                      const char *menu_object_path,
+                                                      const char *sender)
+{
+	registrar_dbus_menu_sender_remove_window(self, window_id);
+	DBusAddress *addr = dbus_address_new(window_id, sender, menu_object_path);
+	g_hash_table_insert(self->menus, GUINT_TO_POINTER(window_id), addr);
+	registrar_dbus_menu_sender_add_window(self, window_id, sender);
+	registrar_dbus_menu_log_change(self, window_id);
+	return addr;
+}
+
+static bool registrar_dbus_menu_remove_window(RegistrarDBusMenu *self, uint window_id)
+{
+	registrar_dbus_menu_sender_remove_window(self, window_id);
+	if (!g_hash_table_remove(self->menus, GUINT_TO_POINTER(window_id)))
+		return false;
+	registrar_dbus_menu_log_change(self, window_id);
+	return true;
+}
+
+// Every change is announced by one windows-changed signal on the private interface, which
+// is all the panel listens to. Per-window signals go to the public interface only, for
+// panels which know nothing else.
+static void registrar_dbus_menu_emit_changed(RegistrarDBusMenu *self, GVariantBuilder *added,
+                                             GVariantBuilder *removed)
+{
+	g_signal_emit(self,
+	              registrar_dbus_menu_signals[WINDOWS_CHANGED_SIGNAL],
+	              0,
+	              g_variant_builder_end(added),
+	              g_variant_builder_end(removed));
+}
+
 void registrar_dbus_menu_register_window(RegistrarDBusMenu *self, uint window_id,
                                          const char *menu_object_path, const char *sender)
 {
+	GVariantBuilder added, removed;
 	g_return_if_fail(self != NULL);
 	g_return_if_fail(menu_object_path != NULL);
 	g_return_if_fail(sender != NULL);
-	DBusAddress *addr = dbus_address_new(sender, menu_object_path);
-	g_hash_table_insert(self->menus, GUINT_TO_POINTER(window_id), addr);
+	DBusAddress *addr =
+	    registrar_dbus_menu_insert_window(self, window_id, menu_object_path, sender);
 	g_signal_emit(self,
 	              registrar_dbus_menu_signals[WINDOW_REGISTERED_SIGNAL],
 	              0,
 	              window_id,
 	              sender,
 	              menu_object_path);
+	g_variant_builder_init(&added, G_VARIANT_TYPE("a(uso)"));
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("au"));
+	g_variant_builder_add_value(&added, addr->entry);
+	registrar_dbus_menu_emit_changed(self, &added, &removed);
 }
 
 void registrar_dbus_menu_unregister_window(RegistrarDBusMenu *self, uint window_id)
 {
+	GVariantBuilder added, removed;
 	g_return_if_fail(self != NULL);
-	g_hash_table_remove(self->menus, GUINT_TO_POINTER(window_id));
+	bool was_registered = registrar_dbus_menu_remove_window(self, window_id);
 	g_signal_emit(self, registrar_dbus_menu_signals[WINDOW_UNREGISTERED_SIGNAL], 0, window_id);
+	if (!was_registered)
+		return;
+	g_variant_builder_init(&added, G_VARIANT_TYPE("a(uso)"));
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("au"));
+	g_variant_builder_add(&removed, "u", window_id);
+	registrar_dbus_menu_emit_changed(self, &added, &removed);
+}
+
+// Bulk versions. Public per-window signals are kept for panels which only know the
+// public interface, they are not seen by the panel.
+void registrar_dbus_menu_register_windows(RegistrarDBusMenu *self, GVariant *windows,
+                                          const char *sender)
+{
+	GVariantBuilder added, removed;
+	GVariantIter iter;
+	uint window_id;
+	const char *menu_object_path;
+	g_return_if_fail(self != NULL);
+	g_return_if_fail(sender != NULL);
+	g_variant_builder_init(&added, G_VARIANT_TYPE("a(uso)"));
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("au"));
+	g_variant_iter_init(&iter, windows);
+	while (g_variant_iter_next(&iter, "(u&o)", &window_id, &menu_object_path))
+	{
+		DBusAddress *addr =
+		    registrar_dbus_menu_insert_window(self, window_id, menu_object_path, sender);
+		g_variant_builder_add_value(&added, addr->entry);
+		g_signal_emit(self,
+		              registrar_dbus_menu_signals[WINDOW_REGISTERED_SIGNAL],
+		              0,
+		              window_id,
+		              sender,
+		              menu_object_path);
+	}
+	registrar_dbus_menu_emit_changed(self, &added, &removed);
+}
+
+void registrar_dbus_menu_unregister_windows(RegistrarDBusMenu *self, GVariant *windows)
+{
+	GVariantBuilder added, removed;
+	GVariantIter iter;
+	uint window_id;
+	g_return_if_fail(self != NULL);
+	g_variant_builder_init(&added, G_VARIANT_TYPE("a(uso)"));
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("au"));
+	g_variant_iter_init(&iter, windows);
+	while (g_variant_iter_next(&iter, "u", &window_id))
+	{
+		if (!registrar_dbus_menu_remove_window(self, window_id))
+			continue;
+		g_variant_builder_add(&removed, "u", window_id);
+		g_signal_emit(self,
+		              registrar_dbus_menu_signals[WINDOW_UNREGISTERED_SIGNAL],
+		              0,
+		              window_id);
+	}
+	registrar_dbus_menu_emit_changed(self, &added, &removed);
+}
+
+// Drops all windows of a client which left the bus
+static void registrar_dbus_menu_remove_sender(RegistrarDBusMenu *self, const char *sender)
+{
+	gpointer key, value;
+	GHashTableIter iter;
+	char *name;
+	GHashTable *windows;
+	GVariantBuilder added, removed;
+	if (!g_hash_table_lookup_extended(self->senders,
+	                                  sender,
+	                                  (gpointer *)&name,
+	                                  (gpointer *)&windows))
+		return;
+	g_hash_table_steal(self->senders, sender);
+	g_variant_builder_init(&added, G_VARIANT_TYPE("a(uso)"));
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("au"));
+	g_hash_table_iter_init(&iter, windows);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		g_hash_table_remove(self->menus, key);
+		registrar_dbus_menu_log_change(self, GPOINTER_TO_UINT(key));
+		g_variant_builder_add(&removed, "u", GPOINTER_TO_UINT(key));
+		g_signal_emit(self,
+		              registrar_dbus_menu_signals[WINDOW_UNREGISTERED_SIGNAL],
+		              0,
+		              GPOINTER_TO_UINT(key));
+	}
+	registrar_dbus_menu_emit_changed(self, &added, &removed);
+	g_hash_table_unref(windows);
+	g_free(name);
+}
+
+static void registrar_dbus_menu_name_owner_changed(GDBusConnection *connection,
+                                                   const char *sender_name,
+                                                   const char *object_path,
+                                                   const char *interface_name,
+                                                   const char *signal_name, GVariant *parameters,
+                                                   gpointer user_data)
+{
+	RegistrarDBusMenu *self = REGISTRAR_DBUS_MENU(user_data);
+	const char *name, *old_owner, *new_owner;
+	g_variant_get(parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+	// Windows are registered by unique names, which never get a new owner
+	if (name[0] != ':' || new_owner[0] != '\0')
+		return;
+	registrar_dbus_menu_remove_sender(self, name);
+}
+
+// Restores windows from the snapshot of a previous instance on the same bus, if their
+// clients are still there. Names are checked by one ListNames call.
+static void registrar_dbus_menu_restore_snapshot(RegistrarDBusMenu *self,
+                                                 GDBusConnection *connection)
+{
+	g_autofree char *path = registrar_dbus_menu_snapshot_path(self);
+	g_autoptr(GError) err = NULL;
+	char *data;
+	gsize len;
+	const char *guid, *bus_name, *object_path;
+	uint window_id;
+	guint64 time;
+	GVariantIter *iter;
+
+	if (!g_file_get_contents(path, &data, &len, NULL))
+		return;
+	g_autoptr(GVariant) snapshot = g_variant_ref_sink(
+	    g_variant_new_from_data(G_VARIANT_TYPE(REGISTRAR_SNAPSHOT_TYPE), data, len, false, g_free, data));
+	g_variant_get(snapshot, "(&sa(usot))", &guid, &iter);
+	if (g_strcmp0(guid, self->bus_guid) != 0 || g_variant_iter_n_children(iter) == 0)
+	{
+		g_variant_iter_free(iter);
+		return;
+	}
+	g_autoptr(GVariant) names = g_dbus_connection_call_sync(connection,
+	                                                        "org.freedesktop.DBus",
+	                                                        "/org/freedesktop/DBus",
+	                                                        "org.freedesktop.DBus",
+	                                                        "ListNames",
+	                                                        NULL,
+	                                                        G_VARIANT_TYPE("(as)"),
+	                                                        G_DBUS_CALL_FLAGS_NONE,
+	                                                        -1,
+	                                                        NULL,
+	                                                        &err);
+	if (names == NULL)
+	{
+		g_warning("Cannot restore registrar snapshot: %s", err->message);
+		g_variant_iter_free(iter);
+		return;
+	}
+	g_autoptr(GHashTable) alive = g_hash_table_new(g_str_hash, g_str_equal);
+	g_autofree const char **name_list = NULL;
+	g_variant_get(names, "(^a&s)", &name_list);
+	for (const char **name = name_list; *name != NULL; name++)
+		g_hash_table_add(alive, (gpointer)*name);
+	while (g_variant_iter_next(iter, "(u&s&ot)", &window_id, &bus_name, &object_path, &time))
+	{
+		if (!g_hash_table_contains(alive, bus_name) ||
+		    g_hash_table_contains(self->menus, GUINT_TO_POINTER(window_id)))
+			continue;
+		DBusAddress *addr = dbus_address_new(window_id, bus_name, object_path);
+		addr->time        = (gint64)time;
+		g_hash_table_insert(self->menus, GUINT_TO_POINTER(window_id), addr);
+		registrar_dbus_menu_sender_add_window(self, window_id, bus_name);
+		registrar_dbus_menu_log_change(self, window_id);
+	}
+	g_variant_iter_free(iter);
 }
 
 void registrar_dbus_menu_get_menu_for_window(RegistrarDBusMenu *self, uint window_id,
-                                             char **service, char **object_path)
+                                             const char **service, const char **object_path)
 {
 	DBusAddress *addr =
 	    (DBusAddress *)g_hash_table_lookup(self->menus, GUINT_TO_POINTER(window_id));
@@ -123,26 +442,69 @@ void registrar_dbus_menu_get_menus(RegistrarDBusMenu *self, GVariant **menus)
 	GHashTableIter iter;
 	gpointer key, value;
 
-	g_variant_builder_init(&bldr, (const GVariantType *)"a(uso)");
+	g_variant_builder_init(&bldr, G_VARIANT_TYPE("a(uso)"));
 	g_hash_table_iter_init(&iter, self->menus);
 	while (g_hash_table_iter_next(&iter, &key, &value))
+		g_variant_builder_add_value(&bldr, ((DBusAddress *)value)->entry);
+	*menus = g_variant_builder_end(&bldr);
+}
+
+// Returns (current revision, full resync, added, removed) for a client which has seen all
+// changes up to the given revision. Windows changed several times are reported once, with
+// their current state.
+GVariant *registrar_dbus_menu_get_menus_since(RegistrarDBusMenu *self, guint64 revision)
+{
+	GVariantBuilder added, removed;
+	GHashTableIter iter;
+	gpointer key, value;
+	GVariant *menus;
+
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("au"));
+	if (revision < self->log_base || revision > self->revision)
 	{
-		char *name;
-		char *path;
-		registrar_dbus_menu_get_menu_for_window(self, GPOINTER_TO_UINT(key), &name, &path);
-		g_variant_builder_add(&bldr, "(uso)", GPOINTER_TO_UINT(key), name, path);
+		registrar_dbus_menu_get_menus(self, &menus);
+		return g_variant_new("(tb@a(uso)au)", self->revision, true, menus, &removed);
 	}
-	*menus = g_variant_builder_end(&bldr);
+	g_autoptr(GHashTable) changed = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (uint i = self->log->len; i > 0; i--)
+	{
+		RegistrarChange *change = &g_array_index(self->log, RegistrarChange, i - 1);
+		if (change->revision <= revision)
+			break;
+		g_hash_table_add(changed, GUINT_TO_POINTER(change->window_id));
+	}
+	g_variant_builder_init(&added, G_VARIANT_TYPE("a(uso)"));
+	g_hash_table_iter_init(&iter, changed);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		DBusAddress *addr = (DBusAddress *)g_hash_table_lookup(self->menus, key);
+		if (addr)
+			g_variant_builder_add_value(&added, addr->entry);
+		else
+			g_variant_builder_add(&removed, "u", GPOINTER_TO_UINT(key));
+	}
+	return g_variant_new("(tba(uso)au)", self->revision, false, &added, &removed);
 }
 
 static void registrar_dbus_menu_init(RegistrarDBusMenu *self)
 {
 	self->menus = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, dbus_address_free);
+	self->senders =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
+	self->log = g_array_new(false, false, sizeof(RegistrarChange));
+	// Start from wall clock, so revisions kept by clients from a previous registrar
+	// instance are older than log_base and force a full resync
+	self->revision = self->log_base = (guint64)g_get_real_time();
 }
 
 static void registrar_dbus_menu_finalize(GObject *obj)
 {
 	RegistrarDBusMenu *self = REGISTRAR_DBUS_MENU(obj);
+	if (self->snapshot_source > 0)
+		g_source_remove(self->snapshot_source);
+	g_free(self->bus_guid);
+	g_array_unref(self->log);
+	g_hash_table_unref(self->senders);
 	g_hash_table_unref(self->menus);
 	G_OBJECT_CLASS(registrar_dbus_menu_parent_class)->finalize(obj);
 }
@@ -174,128 +536,145 @@ static void registrar_dbus_menu_class_init(RegistrarDBusMenuClass *klass)
 	                 G_TYPE_NONE,
 	                 1,
 	                 G_TYPE_UINT);
+	registrar_dbus_menu_signals[WINDOWS_CHANGED_SIGNAL] =
+	    g_signal_new(g_intern_static_string("windows-changed"),
+	                 registrar_dbus_menu_get_type(),
+	                 G_SIGNAL_RUN_LAST,
+	                 0,
+	                 NULL,
+	                 NULL,
+	                 g_cclosure_user_marshal_VOID__VARIANT_VARIANT,
+	                 G_TYPE_NONE,
+	                 2,
+	                 G_TYPE_VARIANT,
+	                 G_TYPE_VARIANT);
 }
 
 static void _dbus_registrar_dbus_menu_register_window(RegistrarDBusMenu *self,
-                                                      GVariant *_parameters_,
+                                                      GVariant *parameters,
                                                       GDBusMethodInvocation *invocation)
 {
-	g_autoptr(GError) error = NULL;
-	GVariantIter _arguments_iter;
-	uint window_id               = 0U;
-	char *menu_object_path       = NULL;
-	GDBusMessage *_reply_message = NULL;
-	GVariant *_reply;
-	GVariantBuilder _reply_builder;
-	g_variant_iter_init(&_arguments_iter, _parameters_);
-	GVariant *value = g_variant_iter_next_value(&_arguments_iter);
-	window_id       = g_variant_get_uint32(value);
-	g_variant_unref(value);
-	value            = g_variant_iter_next_value(&_arguments_iter);
-	menu_object_path = g_variant_dup_string(value, NULL);
-	g_variant_unref(value);
+	uint window_id;
+	const char *menu_object_path;
+	g_variant_get(parameters, "(u&o)", &window_id, &menu_object_path);
 	registrar_dbus_menu_register_window(self,
 	                                    window_id,
 	                                    menu_object_path,
 	                                    g_dbus_method_invocation_get_sender(invocation));
-	_reply_message =
-	    g_dbus_message_new_method_reply(g_dbus_method_invocation_get_message(invocation));
-	g_variant_builder_init(&_reply_builder, G_VARIANT_TYPE_TUPLE);
-	_reply = g_variant_builder_end(&_reply_builder);
-	g_dbus_message_set_body(_reply_message, _reply);
-	g_dbus_connection_send_message(g_dbus_method_invocation_get_connection(invocation),
-	                               _reply_message,
-	                               G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-	                               NULL,
-	                               NULL);
-	g_object_unref(invocation);
-	g_object_unref(_reply_message);
-	g_free(menu_object_path);
+	g_dbus_method_invocation_return_value(invocation, NULL);
 }
 
 static void _dbus_registrar_dbus_menu_unregister_window(RegistrarDBusMenu *self,
-                                                        GVariant *_parameters_,
+                                                        GVariant *parameters,
                                                         GDBusMethodInvocation *invocation)
 {
-	g_autoptr(GError) error = NULL;
-	GVariantIter _arguments_iter;
-	uint window_id               = 0U;
-	GDBusMessage *_reply_message = NULL;
-	GVariant *_reply;
-	GVariantBuilder _reply_builder;
-	g_variant_iter_init(&_arguments_iter, _parameters_);
-	GVariant *value = g_variant_iter_next_value(&_arguments_iter);
-	window_id       = g_variant_get_uint32(value);
-	g_variant_unref(value);
+	uint window_id;
+	g_variant_get(parameters, "(u)", &window_id);
 	registrar_dbus_menu_unregister_window(self, window_id);
-	_reply_message =
-	    g_dbus_message_new_method_reply(g_dbus_method_invocation_get_message(invocation));
-	g_variant_builder_init(&_reply_builder, G_VARIANT_TYPE_TUPLE);
-	_reply = g_variant_builder_end(&_reply_builder);
-	g_dbus_message_set_body(_reply_message, _reply);
-	g_dbus_connection_send_message(g_dbus_method_invocation_get_connection(invocation),
-	                               _reply_message,
-	                               G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-	                               NULL,
-	                               NULL);
-	g_object_unref(invocation);
-	g_object_unref(_reply_message);
+	g_dbus_method_invocation_return_value(invocation, NULL);
 }
 
 static void _dbus_registrar_dbus_menu_get_menu_for_window(RegistrarDBusMenu *self,
-                                                          GVariant *_parameters_,
+                                                          GVariant *parameters,
                                                           GDBusMethodInvocation *invocation)
 {
-	GVariantIter _arguments_iter;
-	uint window                  = 0U;
-	GDBusMessage *_reply_message = NULL;
-	GVariant *_reply;
-	GVariantBuilder _reply_builder;
-	char *service = NULL;
-	char *path    = NULL;
-	g_variant_iter_init(&_arguments_iter, _parameters_);
-	g_autoptr(GVariant) value = g_variant_iter_next_value(&_arguments_iter);
-	window                    = g_variant_get_uint32(value);
-	registrar_dbus_menu_get_menu_for_window(self, window, &service, &path);
-	_reply_message =
-	    g_dbus_message_new_method_reply(g_dbus_method_invocation_get_message(invocation));
-	g_variant_builder_init(&_reply_builder, G_VARIANT_TYPE_TUPLE);
-	g_variant_builder_add_value(&_reply_builder, g_variant_new_string(service));
-	g_variant_builder_add_value(&_reply_builder, g_variant_new_object_path(path));
-	_reply = g_variant_builder_end(&_reply_builder);
-	g_dbus_message_set_body(_reply_message, _reply);
-	g_dbus_connection_send_message(g_dbus_method_invocation_get_connection(invocation),
-	                               _reply_message,
-	                               G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-	                               NULL,
-	                               NULL);
-	g_object_unref(invocation);
-	g_object_unref(_reply_message);
-}
-
-static void _dbus_registrar_dbus_menu_get_menus(RegistrarDBusMenu *self, GVariant *_parameters_,
+	static GVariant *no_menu = NULL;
+	uint window_id;
+	g_variant_get(parameters, "(u)", &window_id);
+	DBusAddress *addr =
+	    (DBusAddress *)g_hash_table_lookup(self->menus, GUINT_TO_POINTER(window_id));
+	if (addr)
+	{
+		g_dbus_method_invocation_return_value(invocation, addr->reply);
+		return;
+	}
+	if (g_once_init_enter(&no_menu))
+		g_once_init_leave(&no_menu, g_variant_ref_sink(g_variant_new("(so)", "", "/")));
+	g_dbus_method_invocation_return_value(invocation, no_menu);
+}
+
+static void _dbus_registrar_dbus_menu_get_menus(RegistrarDBusMenu *self, GVariant *parameters,
                                                 GDBusMethodInvocation *invocation)
 {
-	GVariantIter _arguments_iter;
-	GDBusMessage *_reply_message = NULL;
-	GVariant *_reply;
-	GVariantBuilder _reply_builder;
-	GVariant *menus = NULL;
-	g_variant_iter_init(&_arguments_iter, _parameters_);
+	GVariant *menus;
 	registrar_dbus_menu_get_menus(self, &menus);
-	_reply_message =
-	    g_dbus_message_new_method_reply(g_dbus_method_invocation_get_message(invocation));
-	g_variant_builder_init(&_reply_builder, G_VARIANT_TYPE_TUPLE);
-	g_variant_builder_add_value(&_reply_builder, menus);
-	_reply = g_variant_builder_end(&_reply_builder);
-	g_dbus_message_set_body(_reply_message, _reply);
-	g_dbus_connection_send_message(g_dbus_method_invocation_get_connection(invocation),
-	                               _reply_message,
-	                               G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-	                               NULL,
-	                               NULL);
-	g_object_unref(invocation);
-	g_object_unref(_reply_message);
+	g_dbus_method_invocation_return_value(invocation, g_variant_new_tuple(&menus, 1));
+}
+
+static void _dbus_registrar_dbus_menu_get_menus_since(RegistrarDBusMenu *self,
+                                                      GVariant *parameters,
+                                                      GDBusMethodInvocation *invocation)
+{
+	guint64 revision;
+	g_variant_get(parameters, "(t)", &revision);
+	g_dbus_method_invocation_return_value(invocation,
+	                                      registrar_dbus_menu_get_menus_since(self, revision));
+}
+
+static void _dbus_registrar_dbus_menu_register_windows(RegistrarDBusMenu *self,
+                                                       GVariant *parameters,
+                                                       GDBusMethodInvocation *invocation)
+{
+	g_autoptr(GVariant) windows = g_variant_get_child_value(parameters, 0);
+	registrar_dbus_menu_register_windows(self,
+	                                     windows,
+	                                     g_dbus_method_invocation_get_sender(invocation));
+	g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+static void _dbus_registrar_dbus_menu_unregister_windows(RegistrarDBusMenu *self,
+                                                         GVariant *parameters,
+                                                         GDBusMethodInvocation *invocation)
+{
+	g_autoptr(GVariant) windows = g_variant_get_child_value(parameters, 0);
+	registrar_dbus_menu_unregister_windows(self, windows);
+	g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+typedef void (*RegistrarMethodHandler)(RegistrarDBusMenu *self, GVariant *parameters,
+                                       GDBusMethodInvocation *invocation);
+
+static const struct
+{
+	const char *name;
+	RegistrarMethodHandler handler;
+} registrar_dbus_menu_method_table[] = {
+	{ "RegisterWindow", _dbus_registrar_dbus_menu_register_window },
+	{ "UnregisterWindow", _dbus_registrar_dbus_menu_unregister_window },
+	{ "GetMenuForWindow", _dbus_registrar_dbus_menu_get_menu_for_window },
+	{ "GetMenus", _dbus_registrar_dbus_menu_get_menus },
+	// Private interface, GDBus rejects them on the public one, as it does not declare them
+	{ "GetMenusSince", _dbus_registrar_dbus_menu_get_menus_since },
+	{ "RegisterWindows", _dbus_registrar_dbus_menu_register_windows },
+	{ "UnregisterWindows", _dbus_registrar_dbus_menu_unregister_windows },
+};
+
+// Method name -> handler, filled once on first call
+static GHashTable *registrar_dbus_menu_methods = NULL;
+
+// Dispatches methods of both public and private interfaces
+void registrar_dbus_menu_method_call(RegistrarDBusMenu *self, const char *method_name,
+                                     GVariant *parameters, GDBusMethodInvocation *invocation)
+{
+	if (g_once_init_enter(&registrar_dbus_menu_methods))
+	{
+		GHashTable *methods = g_hash_table_new(g_str_hash, g_str_equal);
+		for (size_t i = 0; i < G_N_ELEMENTS(registrar_dbus_menu_method_table); i++)
+			g_hash_table_insert(methods,
+			                    (gpointer)registrar_dbus_menu_method_table[i].name,
+			                    (gpointer)registrar_dbus_menu_method_table[i].handler);
+		g_once_init_leave(&registrar_dbus_menu_methods, methods);
+	}
+	RegistrarMethodHandler handler =
+	    (RegistrarMethodHandler)g_hash_table_lookup(registrar_dbus_menu_methods, method_name);
+	if (handler)
+		handler(self, parameters, invocation);
+	else
+		g_dbus_method_invocation_return_error(invocation,
+		                                      G_DBUS_ERROR,
+		                                      G_DBUS_ERROR_UNKNOWN_METHOD,
+		                                      "Unknown method %s",
+		                                      method_name);
 }
 
 static void registrar_dbus_menu_dbus_interface_method_call(
@@ -303,27 +682,10 @@ static void registrar_dbus_menu_dbus_interface_method_call(
     const char *interface_name, const char *method_name, GVariant *parameters,
     GDBusMethodInvocation *invocation, gpointer user_data)
 {
-	RegistrarDBusMenu *object = REGISTRAR_DBUS_MENU(user_data);
-	if (g_strcmp0(method_name, "RegisterWindow") == 0)
-	{
-		_dbus_registrar_dbus_menu_register_window(object, parameters, invocation);
-	}
-	else if (g_strcmp0(method_name, "UnregisterWindow") == 0)
-	{
-		_dbus_registrar_dbus_menu_unregister_window(object, parameters, invocation);
-	}
-	else if (g_strcmp0(method_name, "GetMenuForWindow") == 0)
-	{
-		_dbus_registrar_dbus_menu_get_menu_for_window(object, parameters, invocation);
-	}
-	else if (g_strcmp0(method_name, "GetMenus") == 0)
-	{
-		_dbus_registrar_dbus_menu_get_menus(object, parameters, invocation);
-	}
-	else
-	{
-		g_object_unref(invocation);
-	}
+	registrar_dbus_menu_method_call(REGISTRAR_DBUS_MENU(user_data),
+	                                method_name,
+	                                parameters,
+	                                invocation);
 }
 
 static void _dbus_registrar_dbus_menu_window_registered(GObject *_sender, uint window_id,
@@ -373,6 +735,15 @@ static const GDBusInterfaceVTable _interface_vtable = {
 void registrar_dbus_menu_unregister(RegistrarDBusMenu *data, GDBusConnection *con)
 {
 	g_dbus_connection_unregister_object(con, data->registered_object);
+	if (data->name_owner_subscription > 0)
+		g_dbus_connection_signal_unsubscribe(con, data->name_owner_subscription);
+	data->name_owner_subscription = 0;
+	// Flush pending changes, so next instance can restore them
+	if (data->snapshot_source > 0)
+	{
+		g_source_remove(data->snapshot_source);
+		registrar_dbus_menu_save_snapshot(data);
+	}
 	g_signal_handlers_disconnect_by_func(data,
 	                                     _dbus_registrar_dbus_menu_window_registered,
 	                                     con);
@@ -398,6 +769,21 @@ uint registrar_dbus_menu_register(RegistrarDBusMenu *object, GDBusConnection *co
 		return 0;
 	}
 	object->registered_object = result;
+	object->name_owner_subscription =
+	    g_dbus_connection_signal_subscribe(connection,
+	                                       "org.freedesktop.DBus",
+	                                       "org.freedesktop.DBus",
+	                                       "NameOwnerChanged",
+	                                       "/org/freedesktop/DBus",
+	                                       NULL,
+	                                       G_DBUS_SIGNAL_FLAGS_NONE,
+	                                       registrar_dbus_menu_name_owner_changed,
+	                                       object,
+	                                       NULL);
+	// Clients which vanish after ListNames are dropped by the subscription above
+	g_free(object->bus_guid);
+	object->bus_guid = g_strdup(g_dbus_connection_get_guid(connection));
+	registrar_dbus_menu_restore_snapshot(object, connection);
 	g_signal_connect(object,
 	                 "window-registered",
 	                 (GCallback)_dbus_registrar_dbus_menu_window_registered,
@@ -30,6 +30,12 @@ G_DECLARE_FINAL_TYPE(RegistrarDBusMenu, registrar_dbus_menu, REGISTRAR, DBUS_MEN
 uint registrar_dbus_menu_register(RegistrarDBusMenu *object, GDBusConnection *connection,
                                   GError **error);
 void registrar_dbus_menu_unregister(RegistrarDBusMenu *data, GDBusConnection *con);
+void registrar_dbus_menu_method_call(RegistrarDBusMenu *self, const char *method_name,
+                                     GVariant *parameters, GDBusMethodInvocation *invocation);
+GVariant *registrar_dbus_menu_get_menus_since(RegistrarDBusMenu *self, guint64 revision);
+void registrar_dbus_menu_register_windows(RegistrarDBusMenu *self, GVariant *windows,
+                                          const char *sender);
+void registrar_dbus_menu_unregister_windows(RegistrarDBusMenu *self, GVariant *windows);
 
 G_END_DECLS
 
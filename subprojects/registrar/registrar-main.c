@@ -125,9 +125,23 @@ static void registrar_application_method_call(GDBusConnection *connection, const
 	}
 	else
 	{
-		g_object_unref(invocation);
+		RegistrarApplication *self = REGISTRAR_APPLICATION(user_data);
+		registrar_dbus_menu_method_call(self->registrar, method_name, parameters, invocation);
 	}
 }
+static void registrar_application_windows_changed(RegistrarDBusMenu *registrar, GVariant *added,
+                                                  GVariant *removed, gpointer user_data)
+{
+	GApplication *app = G_APPLICATION(user_data);
+	g_dbus_connection_emit_signal(g_application_get_dbus_connection(app),
+	                              NULL,
+	                              g_application_get_dbus_object_path(app),
+	                              "org.valapanel.AppMenu.Registrar",
+	                              "WindowsChanged",
+	                              g_variant_new("(@a(uso)@au)", added, removed),
+	                              NULL);
+}
+
 static const GDBusInterfaceVTable _interface_vtable = { registrar_application_method_call,
 	                                                NULL,
 	                                                NULL };
@@ -159,6 +173,10 @@ static int registrar_application_dbus_register(GApplication *base, GDBusConnecti
 	                                      self,
 	                                      NULL,
 	                                      error);
+	g_signal_connect(self->registrar,
+	                 "windows-changed",
+	                 G_CALLBACK(registrar_application_windows_changed),
+	                 self);
 
 	return ret && self->dbusmenu_binding && self->private_binding;
 }
@@ -169,6 +187,9 @@ static void registrar_application_dbus_unregister(GApplication *base, GDBusConne
 	g_return_if_fail(connection != NULL);
 	g_return_if_fail(object_path != NULL);
 	g_bus_unown_name(self->dbusmenu_binding);
+	g_signal_handlers_disconnect_by_func(self->registrar,
+	                                     registrar_application_windows_changed,
+	                                     self);
 	registrar_dbus_menu_unregister(self->registrar, connection);
 	g_dbus_connection_unregister_object(connection, self->private_binding);
 	self->dbusmenu_binding = 0;